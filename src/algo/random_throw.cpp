@@ -25,7 +25,6 @@
 #include <vector>
 #include <climits>
 
-#include "random.h"
 #include "general.h"
 #include "io.h"
 #include "stack_algorithm.h"
@@ -41,17 +40,7 @@ class MyProgram : public Program
 	{
 		FILE* const out_fp = stdout;
 		AvalancheContainer avalanche_container(dim.area_without_border() * 2, out_fp);
-		for(unsigned int round = 0; round < random_seq.size(); round++)
-		{
-			//std::cout << "ROUND " << round << std::endl;
-			grid[random_seq[round]]++;
-	/*		for(int i = 0; i < grid.size(); ++i) {
-				if(grid[i]==-1)
-					assert(false);
-			}*/
-			sandpile::l_hint<T>(grid, dim, random_seq[round],
-				avalanche_container);
-		}
+		sandpile::throw_grains(grid, dim, random_seq, avalanche_container);
 	}
 
 	exit_t main()
@@ -65,16 +54,8 @@ class MyProgram : public Program
 		if(!strcmp(argv[1], "random"))
 		{ // user gives us the random seed, the number, and the initial board via stdin
 			read_grid(stdin, &grid, &dim);
-
-			random_seq.resize(atoi(argv[2]));
-			sca_random::set_seed(atoi(argv[3]));
-
-			const int area = dim.area_without_border();
-
-			for(std::vector<int>::iterator itr = random_seq.begin();
-				itr != random_seq.end(); itr++) {
-				*itr = human2internal(sca_random::get_int(area-1), dim.width());
-			}
+			random_seq = sandpile::random_throw_sequence(dim,
+				atoi(argv[2]), atoi(argv[3]));
 		}
 		else if(!strcmp(argv[1], "input"))
 		{ // user lets us read "random" sequence from stdin, we create an empty board of wxh
@@ -30,9 +30,13 @@ class MyProgram : public Program
 	exit_t main()
 	{
 		const char *tbl_name = nullptr;
+		unsigned n_threads = 0;
 
 		switch(argc)
 		{
+			case 3:
+				assert_usage(isdigit(argv[2][0]));
+				n_threads = atoi(argv[2]);
 			case 2: tbl_name = argv[1];
 				break;
 			case 1:
@@ -50,8 +54,9 @@ class MyProgram : public Program
 
 		grid_t result = input;
 
+		const calc_t::active_map_t active = ca.active_map(input, n_threads);
 		for(const point& p : input.points()) {
-			result[p] = ca.is_cell_active(input, p);
+			result[p] = active[p];
 		}
 		std::cout << result;
 
@@ -62,10 +67,12 @@ class MyProgram : public Program
 int main(int argc, char** argv)
 {
 	HelpStruct help;
-	help.syntax = "ca/active_cells <ca-table-file>"
+	help.syntax = "ca/active_cells <ca-table-file> [<threads>]"
 		"";
 	help.description = "Visualizes which cells are active";
 	help.add_param("<ca-table-file>", "path to ca in table format");
+	help.add_param("threads", "number of threads, "
+		"0 (default) means one per core");
 	help.input = "the input configuration";
 	help.output = "boolean grid which is true where the input grid is active";
 
@@ -18,8 +18,16 @@
 /* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
 /*************************************************************************/
 
+#include <atomic>
 #include <cstring>
+#include <chrono>
 #include <climits>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "simulate.h"
 #include "general.h"
@@ -27,6 +35,10 @@
 #include "ca.h"
 #include "ca_eqs.h"
 #include "ca_table.h"
+#include "ca/bitsliced.h"
+#include "ca/hashlife.h"
+#include "trajectory.h"
+#include "cycle.h"
 
 using namespace sca;
 
@@ -39,10 +51,14 @@ class MyProgram : public Program, sim::ulator
 		bool async = false;
 		int num_steps = INT_MAX;
 		unsigned seed = sca_random::find_good_seed();
+		unsigned n_threads = 1;
 		sim_type sim = sim_type::end;
+		double fps = 10.0;
 
 		switch(argc)
 		{
+			case 7:
+				n_threads = atoi(argv[6]);
 			case 6:
 				seed = atoi(argv[5]);
 			case 5:
@@ -52,7 +68,14 @@ class MyProgram : public Program, sim::ulator
 			case 4:
 				num_steps = atoi(argv[3]);
 			case 3:
-				sim = type_by_str(argv[2]);
+				if(!strncmp(argv[2], "anim:", 5))
+				{
+					sim = sim_type::anim;
+					fps = atof(argv[2] + 5);
+					assert_usage(fps > 0);
+				}
+				else
+				 sim = type_by_str(argv[2]);
 				if(sim == sim_type::undefined)
 				 exit_usage();
 			case 2:
@@ -66,31 +89,259 @@ class MyProgram : public Program, sim::ulator
 		exit_t result;
 
 		// choose ca type
-		if(!strncmp(equation, "table:", 6))
+		if(!strncmp(equation, "hashlife:", 9))
+		{
+			std::ifstream ifs(equation + 9);
+			const ca::_calculator_t<ca::table_t, def_coord_traits,
+				def_cell_traits> calc(ifs);
+			result = func_hashlife(calc, sim, num_steps, async);
+		}
+		else if(!strncmp(equation, "table:", 6))
 		{
-			std::ifstream ifs(equation + 6);
-			ca::simulator_t<ca::table_t, def_coord_traits,
-				def_cell_traits> simulator(ifs);
-			result = func(simulator, sim, num_steps, async, seed);
+			using sim_t = ca::simulator_t<ca::table_t, def_coord_traits,
+				def_cell_traits>;
+			const auto make_sim = [&]() -> std::unique_ptr<sim_t> {
+				std::ifstream ifs(equation + 6);
+				return std::unique_ptr<sim_t>(new sim_t(ifs));
+			};
+			result = func(make_sim, sim, num_steps, async, seed, n_threads,
+				fps);
 		}
 		else
 		{
-			ca::simulator_t<ca::eqsolver_t, def_coord_traits,
-				def_cell_traits> simulator(equation, async);
-			result = func(simulator, sim, num_steps, async, seed);
+			using sim_t = ca::simulator_t<ca::eqsolver_t, def_coord_traits,
+				def_cell_traits>;
+			const auto make_sim = [&]() -> std::unique_ptr<sim_t> {
+				return std::unique_ptr<sim_t>(new sim_t(equation, async));
+			};
+			result = func(make_sim, sim, num_steps, async, seed, n_threads,
+				fps);
 		}
 
 		return result;
 	}
 
-	template<class CaType>
-	exit_t func(ca::simulator_t<CaType,  def_coord_traits, def_cell_traits>& simulator,
+	exit_t func_hashlife(const ca::_calculator_t<ca::table_t,
+			def_coord_traits, def_cell_traits>& calc,
+		const sim_type& sim,
+		const int& num_steps,
+		const bool& async)
+	{
+		if(async)
+		 exit("Sorry, hashlife only supports synchronous CAs.");
+		if(sim != sim_type::end && sim != sim_type::bench)
+		 exit("Sorry, hashlife only supports `end' and `bench'.");
+		if(num_steps == INT_MAX)
+		 exit("Hashlife needs a number of rounds.");
+
+		grid_t grid(calc.border_width());
+		std::cin >> grid;
+
+		const auto start = std::chrono::steady_clock::now();
+		ca::hashlife_t<def_coord_traits, def_cell_traits> hl(calc, grid);
+		hl.advance(num_steps);
+		hl.get_grid(grid);
+
+		if(sim == sim_type::bench)
+		{
+			const std::chrono::duration<double> secs =
+				std::chrono::steady_clock::now() - start;
+			std::cout << "rounds: " << num_steps << std::endl
+				<< "seconds: " << secs.count() << std::endl
+				<< "nodes: " << hl.num_nodes() << std::endl;
+		}
+		else
+		 std::cout << grid;
+
+		return exit_t::success;
+	}
+
+	//! length of the transient before the cycle of length @a period,
+	//!   found by running two simulators from @a start
+	template<class MakeSim>
+	static int transient_length(const MakeSim& make_sim,
+		const grid_t& start, std::size_t period)
+	{
+		const auto tortoise = make_sim(), hare = make_sim();
+		tortoise->grid() = start;
+		hare->grid() = start;
+		tortoise->finalize();
+		hare->finalize();
+		for(std::size_t i = 0; i < period; ++i)
+		 hare->run_once();
+		int transient = 0;
+		for(; tortoise->board_hash() != hare->board_hash(); ++transient)
+		{
+			tortoise->run_once();
+			hare->run_once();
+		}
+		return transient;
+	}
+
+	template<class Solver>
+	static bool bitsliced_supports(const ca::_calculator_t<Solver,
+			def_coord_traits, def_cell_traits>& calc, const grid_t& grid)
+	{
+		using bitsliced_t = ca::bitsliced_t<Solver, def_coord_traits,
+			def_cell_traits>;
+		return bitsliced_t::supports(grid) && bitsliced_t::supports(calc);
+	}
+
+	//! simulates @a grid with a bit-sliced simulator, like func() does
+	//!   for synchronous end and bench runs
+	template<class Solver>
+	exit_t func_bitsliced(const ca::_calculator_t<Solver,
+			def_coord_traits, def_cell_traits>& calc,
+		grid_t& grid,
+		const sim_type& sim,
+		const int& num_steps)
+	{
+		using bitsliced_t = ca::bitsliced_t<Solver, def_coord_traits,
+			def_cell_traits>;
+		bitsliced_t bs(calc, grid);
+		const bitsliced_t start_bs = bs;
+
+		brent_detector_t brent;
+		brent.feed(bs.hash());
+
+		const auto start = std::chrono::steady_clock::now();
+		int round = 0;
+		bool fixed_point = false;
+		for(; round < num_steps; ++round)
+		{
+			if(!bs.run_once())
+			{
+				fixed_point = true;
+				break;
+			}
+			if(brent.feed(bs.hash()))
+			{
+				++round;
+				break;
+			}
+		}
+
+		if(brent.cycle_found())
+		{
+			const std::size_t period = brent.period();
+			bitsliced_t tortoise = start_bs, hare = start_bs;
+			for(std::size_t i = 0; i < period; ++i)
+			 hare.run_once();
+			int transient = 0;
+			for(; tortoise.hash() != hare.hash(); ++transient)
+			{
+				tortoise.run_once();
+				hare.run_once();
+			}
+			std::cerr << "Cycle found after " << round << " rounds: "
+				<< "transient length " << transient
+				<< ", period " << period << std::endl;
+			if(num_steps != INT_MAX)
+			for(std::size_t i = (num_steps - round) % period; i; --i, ++round)
+			 bs.run_once();
+		}
+		else if(fixed_point)
+		 std::cerr << "Fixed point after " << round << " rounds."
+			<< std::endl;
+
+		if(sim == sim_type::bench)
+		{
+			const std::chrono::duration<double> secs =
+				std::chrono::steady_clock::now() - start;
+			std::cout << "rounds: " << round << std::endl
+				<< "seconds: " << secs.count() << std::endl;
+			if(round)
+			 std::cout << "us/round: " << secs.count() * 1e6 / round
+				<< std::endl
+				<< "cells/second: " << bs.area() * (double)round
+					/ secs.count() << std::endl;
+		}
+		else
+		{
+			bs.get_grid(grid);
+			std::cout << grid;
+		}
+		return exit_t::success;
+	}
+
+	/**
+	 * Runs @a run_once in a thread at full speed, while the grid is
+	 * printed @a fps times per second. The simulation thread only
+	 * copies the grid when the printing thread asks for a frame, so
+	 * the rounds in between are not printed.
+	 */
+	template<class Simulator, class RunOnce>
+	static void animate(Simulator& simulator, const RunOnce& run_once,
+		int num_steps, double fps)
+	{
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::atomic<bool> want_frame(false);
+		bool done = false;
+		grid_t frame = simulator.grid();
+
+		const auto start = std::chrono::steady_clock::now();
+		std::chrono::duration<double> secs;
+		int round = 0;
+		std::thread sim_thread([&]() {
+			for(; (round < num_steps) && simulator.can_run(); ++round)
+			{
+				run_once();
+				if(want_frame.load(std::memory_order_relaxed))
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					frame = simulator.grid();
+					want_frame = false;
+					cond.notify_one();
+				}
+			}
+			secs = std::chrono::steady_clock::now() - start;
+			std::lock_guard<std::mutex> lock(mutex);
+			done = true;
+			cond.notify_one();
+		});
+
+		const std::chrono::duration<double> period(1.0 / fps);
+		auto next = start;
+		unsigned frames = 0;
+		for(bool last = false; !last; ++frames)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				last = done;
+				if(last)
+				 frame = simulator.grid();
+				os_clear();
+				std::cout << frame << std::endl;
+			}
+			next += std::chrono::duration_cast<
+				std::chrono::steady_clock::duration>(period);
+			std::this_thread::sleep_until(next);
+			std::unique_lock<std::mutex> lock(mutex);
+			want_frame = !done;
+			cond.wait(lock, [&]{ return !want_frame || done; });
+		}
+		sim_thread.join();
+
+		std::cerr << "rounds: " << round << std::endl
+			<< "frames: " << frames << std::endl
+			<< "rounds/second: " << round / secs.count() << std::endl;
+	}
+
+	//! @param make_sim returns a new simulator as a std::unique_ptr
+	template<class MakeSim>
+	exit_t func(const MakeSim& make_sim,
 		const sim_type& sim,
 		const int& num_steps,
 		const bool& async,
-		unsigned seed)
+		unsigned seed,
+		unsigned n_threads,
+		double fps)
 	{
-		using ca_sim_t = ca::simulator_t<CaType,  def_coord_traits, def_cell_traits>;
+		const auto sim_ptr = make_sim();
+		auto& simulator = *sim_ptr;
+		using ca_sim_t = typename std::remove_reference<
+			decltype(simulator)>::type;
 
 		//FILE* const in_fp = stdin;
 		//FILE* const out_fp = stdout;
@@ -103,8 +354,6 @@ class MyProgram : public Program, sim::ulator
 		{
 			case sim_type::role:
 				break;
-			case sim_type::anim:
-				/*os_clear();*/ break;
 			case sim_type::more:
 				exit("Sorry, `more' is not supported yet.");
 			default:
@@ -128,42 +377,118 @@ class MyProgram : public Program, sim::ulator
 		ca::ca_simulator_t simulator(equation, max, async);
 		simulator.grid() = tmp_grid;
 #endif
+		// life-like CAs on grids of 0 and 1 are simulated bit-sliced
+		if(!async && (sim == sim_type::end || sim == sim_type::bench)
+			&& bitsliced_supports(simulator.calculator(), simulator.grid()))
+		 return func_bitsliced(simulator.calculator(), simulator.grid(),
+			sim, num_steps);
+
+		// in these cases, the run can stop at cycles
+		const bool detect_cycles = !async && simulator.deterministic()
+			&& (sim == sim_type::end || sim == sim_type::bench);
+		grid_t start_grid;
+		if(detect_cycles)
+		 start_grid = simulator.grid();
+
 		simulator.finalize();
 
-		for(int round = 0; (round < num_steps) && simulator.can_run(); ++round)
+		// TODO: why is the param necessary?
+		const auto run_once = [&]() {
+			if(async && n_threads != 1)
+			 simulator.run_once(typename ca_sim_t::parallel_asynchronicity(
+				n_threads));
+			else if(async)
+			 simulator.run_once(typename ca_sim_t::default_asynchronicity());
+			else
+			 simulator.run_once(typename ca_sim_t::synchronous());
+		};
+
+		if(sim == sim_type::anim)
+		{
+			animate(simulator, run_once, num_steps, fps);
+			return exit_t::success;
+		}
+
+		brent_detector_t brent;
+		if(detect_cycles)
+		 brent.feed(simulator.board_hash());
+
+		// records the start grid and then one frame per round
+		std::unique_ptr<io::trajectory_writer_t> recorder;
+		std::vector<point> written;
+		if(sim == sim_type::record)
 		{
-			if(sim != sim_type::end)
+			recorder.reset(new io::trajectory_writer_t(out_fp,
+				simulator.grid().human_dim()));
+			recorder->add(simulator.grid());
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		int round = 0;
+		for(; (round < num_steps) && simulator.can_run(); ++round)
+		{
+			if(recorder)
+			{
+				// the simulator knows which cells the next round writes
+				written.clear();
+				simulator.for_each_next_written([&](const point& p) {
+					written.push_back(p); });
+			}
+			else if(sim != sim_type::end && sim != sim_type::bench)
 			{
-				if(sim == sim_type::anim)
-				 os_clear();
 				out_fp << simulator.grid() << std::endl;
-				switch(sim)
-				{
-					case sim_type::anim:
-						os_sleep(1);
-						break;
-					case sim_type::more:
-						while(getchar()!='\n') ; // TODO: use in_fp
-						break;
-					default: break;
-				}
+				if(sim == sim_type::more)
+				 while(getchar()!='\n') ; // TODO: use in_fp
 			}
 
-			// TODO: why is the param necessary?
-			if(async)
-			 simulator.run_once(typename ca_sim_t::default_asynchronicity());
-			else
-			 simulator.run_once(typename ca_sim_t::synchronous());
+			run_once();
+
+			if(recorder)
+			 recorder->add(simulator.grid(), written);
+
+			if(detect_cycles && brent.feed(simulator.board_hash()))
+			{
+				++round;
+				break;
+			}
 		}
 
-		if(sim == sim_type::anim)
-		 os_clear();
-		out_fp << simulator.grid();
-		if(sim == sim_type::anim) {
-			out_fp << std::endl;
-			os_sleep(1);
+		if(brent.cycle_found())
+		{
+			const std::size_t period = brent.period();
+			std::cerr << "Cycle found after " << round << " rounds: "
+				<< "transient length "
+				<< transient_length(make_sim, start_grid, period)
+				<< ", period " << period << std::endl;
+			// the grid after num_steps rounds is in the cycle, too
+			if(num_steps != INT_MAX)
+			for(std::size_t i = (num_steps - round) % period; i; --i, ++round)
+			 simulator.run_once();
+		}
+		else if(detect_cycles && !simulator.can_run())
+		 std::cerr << "Fixed point after " << round << " rounds."
+			<< std::endl;
+
+		if(recorder)
+		{
+			recorder->finish();
+			return exit_t::success;
+		}
+
+		if(sim == sim_type::bench)
+		{
+			const std::chrono::duration<double> secs =
+				std::chrono::steady_clock::now() - start;
+			out_fp << "rounds: " << round << std::endl
+				<< "seconds: " << secs.count() << std::endl;
+			if(round)
+			 out_fp << "us/round: " << secs.count() * 1e6 / round
+				<< std::endl;
+			return exit_t::success;
 		}
 
+		out_fp << simulator.grid();
+
 		return exit_t::success;
 	}
 };
@@ -172,12 +497,25 @@ int main(int argc, char** argv)
 {
 	HelpStruct help;
 	help.syntax = "ca/ca <equation> "
-		"[<sim_type> [<rounds> [sync|async [seed]]]]";
-	help.description = "Runs a cellular automaton (ca).";
+		"[<sim_type> [<rounds> [sync|async [seed [threads]]]]]";
+	help.description = "Runs a cellular automaton (ca). Synchronous end "
+		"and bench runs of 2 state, outer totalistic CAs on the Moore "
+		"neighbourhood, like game of life, are bit-sliced automatically.";
 	help.input = "start configuration of the ca";
 	help.output = "configuration after the simulation";
-	help.add_param("equation", "specifies the equation which determines the ca");
+	help.add_param("equation", "specifies the equation which determines the ca, "
+		"or table:<file> for a table file, or hashlife:<file> to simulate "
+		"a table file with hashlife (sync, end or bench only, "
+		"rounds are required)");
+	help.add_param("sim_type", "end (default), role, more, anim, "
+		"anim:<fps> to print <fps> frames per second while simulating "
+		"at full speed (anim means anim:10), "
+		"record for a binary trajectory, see ca/replay, or bench "
+		"to print timings instead of grids");
 	help.add_param("rounds", "number of rounds to simulate; if not given, simulates until stable");
+	help.add_param("threads", "for async: number of threads, each with "
+		"its own random numbers, 0 means one per core. "
+		"1 (default) uses the global random numbers");
 
 	MyProgram p;
 	return p.run(argc, argv, &help);
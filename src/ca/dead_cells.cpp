@@ -30,9 +30,13 @@ class MyProgram : public Program
 	exit_t main()
 	{
 		const char *tbl_name = nullptr;
+		unsigned n_threads = 0;
 
 		switch(argc)
 		{
+			case 3:
+				assert_usage(isdigit(argv[2][0]));
+				n_threads = atoi(argv[2]);
 			case 2: tbl_name = argv[1];
 				break;
 			case 1:
@@ -49,7 +53,7 @@ class MyProgram : public Program
 		grid_t input(std::cin, ca.border_width());
 
 		ca::dead_cell_scan<ca::table_t, def_coord_traits,
-			def_cell_traits> scanner(ca, 3);
+			def_cell_traits> scanner(ca, 3, n_threads);
 		grid_t dead_cells = scanner(input);
 
 		std::cout << dead_cells;
@@ -61,7 +65,7 @@ class MyProgram : public Program
 int main(int argc, char** argv)
 {
 	HelpStruct help;
-	help.syntax = "ca/dead_cells <ca-table-file>"
+	help.syntax = "ca/dead_cells <ca-table-file> [<threads>]"
 		"";
 	help.description = "Returns grid of dead cells:\n"
 		" 3 - cell is in dead state (regardless of grid)\n"
@@ -69,6 +73,8 @@ int main(int argc, char** argv)
 		" 1 - cell can never get active because of (fixed) neighbours\n"
 		" 0 - cell might get active";
 	help.add_param("<ca-table-file>", "path to ca in table format");
+	help.add_param("threads", "number of threads, "
+		"0 (default) means one per core");
 	help.input = "the input configuration";
 	help.output = "the dead cells grid";
 
@@ -0,0 +1,221 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "general.h"
+#include "io.h"
+#include "ca.h"
+#include "ca_eqs.h"
+#include "ca_table.h"
+
+using namespace sca;
+
+class MyProgram : public Program
+{
+	//! reads all grids from stdin, separated by empty lines
+	static std::vector<grid_t> read_grids(unsigned border_width)
+	{
+		std::vector<grid_t> grids;
+		std::string line, text;
+		bool eof;
+		do
+		{
+			eof = !std::getline(std::cin, line);
+			if(eof || line.empty())
+			{
+				if(!text.empty())
+				{
+					std::istringstream iss(text);
+					grids.emplace_back(iss, border_width);
+					text.clear();
+				}
+			}
+			else
+			 text += line + '\n';
+		} while(!eof);
+		return grids;
+	}
+
+	/**
+	 * Runs all jobs. Each thread has its own simulator, sharing
+	 * @a calc, or a copy of it if the solver keeps scratch state
+	 * (see Solver::concurrent_next_state). Results are written in the
+	 * order of the job ids, as soon as all previous jobs are done.
+	 */
+	template<class Solver>
+	void run_jobs(const ca::_calculator_t<Solver, def_coord_traits,
+			def_cell_traits>& calc,
+		const std::vector<grid_t>& grids, unsigned runs,
+		int num_steps, bool async, unsigned seed, unsigned n_threads)
+	{
+		using sim_t = ca::simulator_t<Solver, def_coord_traits,
+			def_cell_traits>;
+
+		const std::size_t n_jobs = grids.size() * runs;
+		std::atomic<std::size_t> next_job(0);
+
+		std::mutex out_mutex;
+		std::vector<std::string> results(n_jobs);
+		std::vector<bool> done(n_jobs, false);
+		std::size_t next_out = 0;
+
+		using calc_t = ca::_calculator_t<Solver, def_coord_traits,
+			def_cell_traits>;
+
+		const auto work = [&]() {
+			std::unique_ptr<calc_t> own_calc;
+			if(!Solver::concurrent_next_state)
+			 own_calc.reset(new calc_t(calc));
+			sim_t simulator(own_calc ? *own_calc : calc, async);
+			for(std::size_t job; (job = next_job++) < n_jobs; )
+			{
+				const std::size_t g = job / runs, r = job % runs;
+
+				// one rng stream per job, independent of the thread
+				std::seed_seq seq { seed, (unsigned)job };
+				unsigned job_seed;
+				seq.generate(&job_seed, &job_seed + 1);
+
+				simulator.grid() = grids[g];
+				simulator.finalize(simulator.grid().human_dim(),
+					job_seed);
+				int round = 0;
+				for(; round < num_steps && simulator.can_run(); ++round)
+				if(async)
+				 simulator.run_once(typename sim_t::own_asynchronicity());
+				else
+				 simulator.run_once();
+
+				std::ostringstream oss;
+				oss << "job " << job << " grid " << g << " run " << r
+					<< " seed " << job_seed << " rounds " << round
+					<< std::endl << simulator.grid() << std::endl;
+
+				std::lock_guard<std::mutex> lock(out_mutex);
+				results[job] = oss.str();
+				done[job] = true;
+				for(; next_out < n_jobs && done[next_out]; ++next_out)
+				{
+					std::cout << results[next_out];
+					std::string().swap(results[next_out]);
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for(unsigned t = 1; t < n_threads; ++t)
+		 threads.emplace_back(work);
+		work();
+		for(std::thread& th : threads)
+		 th.join();
+	}
+
+	exit_t main()
+	{
+		const char* equation = "v";
+		unsigned runs = 1;
+		int num_steps = INT_MAX;
+		bool async = false;
+		unsigned seed = sca_random::find_good_seed();
+		unsigned n_threads = 0;
+
+		switch(argc)
+		{
+			case 7:
+				n_threads = atoi(argv[6]);
+			case 6:
+				seed = atoi(argv[5]);
+			case 5:
+				assert_usage(!strcmp(argv[4],"async")
+					|| !strcmp(argv[4],"sync"));
+				async = (argv[4][0] == 'a');
+			case 4:
+				num_steps = atoi(argv[3]);
+			case 3:
+				runs = atoi(argv[2]);
+			case 2:
+				equation = argv[1];
+				break;
+			case 1:
+			default:
+				exit_usage();
+		}
+
+		if(!n_threads)
+		 n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+		// the ca is parsed only once
+		if(!strncmp(equation, "table:", 6))
+		{
+			std::ifstream ifs(equation + 6);
+			const ca::_calculator_t<ca::table_t, def_coord_traits,
+				def_cell_traits> calc(ifs);
+			run_jobs(calc, read_grids(calc.border_width()), runs,
+				num_steps, async, seed, n_threads);
+		}
+		else
+		{
+			const ca::_calculator_t<ca::eqsolver_t, def_coord_traits,
+				def_cell_traits> calc(equation);
+			run_jobs(calc, read_grids(calc.border_width()), runs,
+				num_steps, async, seed, n_threads);
+		}
+
+		return exit_t::success;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	HelpStruct help;
+	help.syntax = "ca/ensemble <equation> "
+		"[<runs> [<rounds> [sync|async [seed [threads]]]]]";
+	help.description = "Runs many independent simulations of one "
+		"cellular automaton (ca) in parallel.\n"
+		"Each input grid is simulated <runs> times, which only differ "
+		"in async mode.";
+	help.input = "start configurations, separated by empty lines";
+	help.output = "for each job, ordered by job id: a line "
+		"`job <id> grid <grid> run <run> seed <seed> rounds <rounds>', "
+		"the end configuration and an empty line";
+	help.add_param("equation", "specifies the equation which determines "
+		"the ca, or table:<file> for a table file");
+	help.add_param("runs", "number of runs per input grid, default is 1");
+	help.add_param("rounds", "number of rounds to simulate; if not given, "
+		"simulates until stable");
+	help.add_param("seed", "seed from which the seeds of all jobs are "
+		"derived");
+	help.add_param("threads", "number of threads, 0 (default) means one "
+		"per core");
+
+	MyProgram p;
+	return p.run(argc, argv, &help);
+}
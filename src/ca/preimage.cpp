@@ -30,15 +30,27 @@ class MyProgram : public Program
 	exit_t main()
 	{
 		const char *tbl_name = nullptr;
+		bool count_only = false;
+		int n_threads = -1; // -1: depends on dump or count
 
 		switch(argc)
 		{
+			case 4:
+				assert_usage(isdigit(argv[3][0]));
+				n_threads = atoi(argv[3]);
+			case 3:
+				assert_usage(!strcmp(argv[2], "dump")
+					|| !strcmp(argv[2], "count"));
+				count_only = !strcmp(argv[2], "count");
 			case 2: tbl_name = argv[1];
 				break;
 			case 1:
 			default:
 				exit_usage();
 		}
+		// only one thread dumps the preimages in a fixed order
+		if(n_threads < 0)
+		 n_threads = count_only ? 0 : 1;
 
 		std::ifstream in(tbl_name);
 		using calc_t =
@@ -48,7 +60,14 @@ class MyProgram : public Program
 
 		grid_t input(std::cin, ca.border_width());
 
-		ca::dump_preimages(ca, input, 3);
+		if(count_only)
+		{
+			const ca::preimage_finder_t<ca::table_t, def_coord_traits,
+				def_cell_traits> finder(ca, input, ca.num_states());
+			std::cout << finder.count(n_threads) << std::endl;
+		}
+		else
+		 ca::dump_preimages(ca, input, ca.num_states(), std::cout, n_threads);
 
 		return exit_t::success;
 	}
@@ -57,10 +76,16 @@ class MyProgram : public Program
 int main(int argc, char** argv)
 {
 	HelpStruct help;
-	help.syntax = "ca/preimage <ca-table-file>"
+	help.syntax = "ca/preimage <ca-table-file> [dump|count [<threads>]]"
 		"";
 	help.description = "Dumps all preimages of a given input conf.";
 	help.add_param("<ca-table-file>", "path to ca in table format");
+	help.add_param("dump|count", "whether to print the preimages (default) "
+		"or only their number");
+	help.add_param("threads", "number of threads, 0 means one per core. "
+		"Defaults to 1 for dump and to 0 for count. Only for 1, the "
+		"preimages are dumped in a fixed order (lexicographically, row by "
+		"row)");
 	help.input = "the input configuration";
 	help.output = "the preimage grids";
 
@@ -0,0 +1,92 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "general.h"
+#include "grid.h"
+#include "trajectory.h"
+
+class MyProgram : public Program
+{
+	exit_t main()
+	{
+		const char* filename = nullptr;
+		int from = -1, to = -1;
+
+		switch(argc)
+		{
+			case 4:
+				to = atoi(argv[3]);
+			case 3:
+				if(strcmp(argv[2], "all"))
+				 from = atoi(argv[2]);
+				else
+				 from = 0;
+			case 2:
+				filename = argv[1];
+				break;
+			default:
+				exit_usage();
+		}
+
+		std::ifstream ifs(filename, std::ios::in | std::ios::binary);
+		if(!ifs.good())
+		 throw "Error opening trajectory file";
+		sca::io::trajectory_reader_t reader(ifs);
+
+		if(from < 0) // only the last round
+		 from = reader.rounds() - 1;
+		if(to < 0)
+		 to = (argc == 3 && strcmp(argv[2], "all"))
+			? from : reader.rounds() - 1;
+
+		grid_t grid(reader.dim(), 1);
+		for(int round = from; round <= to; ++round)
+		{
+			reader.seek(round, grid);
+			if(round != from)
+			 std::cout << std::endl;
+			std::cout << grid;
+		}
+
+		return exit_t::success;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	HelpStruct help;
+	help.syntax = "ca/replay <trajectory> [<round>|all [<last round>]]";
+	help.description = "Prints grids from a trajectory recorded with "
+		"`ca/ca <equation> record'.";
+	help.input = "none";
+	help.output = "the grids of the given rounds, "
+		"separated by empty lines";
+	help.add_param("trajectory", "file written by ca/ca in record mode");
+	help.add_param("round", "first round to print, default is the "
+		"last round; all prints all rounds");
+	help.add_param("last round", "last round to print, "
+		"default is <round>, or the last round for all");
+	MyProgram p;
+	return p.run(argc, argv, &help);
+}
@@ -0,0 +1,128 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <climits>
+#include <cstring>
+#include <fstream>
+
+#include "general.h"
+#include "io.h"
+#include "ca.h"
+#include "ca_eqs.h"
+#include "ca_table.h"
+#include "ca/sparse_simulator.h"
+
+using namespace sca;
+
+class MyProgram : public Program
+{
+	template<class Solver>
+	void simulate(const ca::_calculator_t<Solver, def_coord_traits,
+			def_cell_traits>& calc, int num_steps, const point& ul,
+		dimension window)
+	{
+		const grid_t input(std::cin, 0);
+		if(!window.area())
+		 window = input.human_dim();
+
+		ca::sparse_simulator_t<Solver, def_coord_traits, def_cell_traits>
+			simulator(calc);
+		for(const point& p : input.points())
+		 simulator.board().set(ul + p, input[p]);
+		simulator.finalize();
+
+		int round = 0;
+		for(; round < num_steps && simulator.can_run(); ++round)
+		 simulator.run_once();
+
+		std::cerr << "rounds: " << round << ", tiles: "
+			<< simulator.board().num_tiles() << ", bytes for cells: "
+			<< simulator.board().cell_bytes() << std::endl;
+
+		grid_t output(window, 0);
+		for(const point& p : output.points())
+		 output[p] = simulator.board()[ul + p];
+		std::cout << output;
+	}
+
+	exit_t main()
+	{
+		const char* equation = "v";
+		int num_steps = INT_MAX;
+		point ul(0, 0);
+		dimension window(0, 0);
+
+		switch(argc)
+		{
+			case 7:
+				window = dimension(atoi(argv[5]), atoi(argv[6]));
+			case 5:
+				ul = point(atoi(argv[3]), atoi(argv[4]));
+			case 3:
+				num_steps = atoi(argv[2]);
+			case 2:
+				equation = argv[1];
+				break;
+			default:
+				exit_usage();
+		}
+
+		if(!strncmp(equation, "table:", 6))
+		{
+			std::ifstream ifs(equation + 6);
+			const ca::_calculator_t<ca::table_t, def_coord_traits,
+				def_cell_traits> calc(ifs);
+			simulate(calc, num_steps, ul, window);
+		}
+		else
+		{
+			const ca::_calculator_t<ca::eqsolver_t, def_coord_traits,
+				def_cell_traits> calc(equation);
+			simulate(calc, num_steps, ul, window);
+		}
+
+		return exit_t::success;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	HelpStruct help;
+	help.syntax = "ca/sparse <equation> "
+		"[<rounds> [<x> <y> [<width> <height>]]]";
+	help.description = "Runs a synchronous cellular automaton (ca) on an "
+		"unbounded board, where all cells are 0 initially.\n"
+		"Memory is only used for areas with cells other than 0, "
+		"so the coordinates can be large.";
+	help.input = "start configuration, placed at (x, y)";
+	help.output = "the area at (x, y) after the simulation";
+	help.add_param("equation", "specifies the equation which determines "
+		"the ca, or table:<file> for a table file; it may only write v, "
+		"and 0 must be quiescent");
+	help.add_param("rounds", "number of rounds to simulate; if not given, "
+		"simulates until stable");
+	help.add_param("x, y", "position of the start configuration, "
+		"default is (0, 0)");
+	help.add_param("width, height", "size of the output area, default is "
+		"the size of the start configuration");
+
+	MyProgram p;
+	return p.run(argc, argv, &help);
+}
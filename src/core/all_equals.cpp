@@ -22,6 +22,7 @@
 #include <cassert>
 
 #include "grid.h"
+#include "grid_algebra.h"
 #include "general.h"
 
 class MyProgram : public Program
@@ -36,10 +37,7 @@ class MyProgram : public Program
 		else
 		 exit_usage();
 
-		auto itr = grid.cbegin();
-		for( ; itr != grid.cend() && *itr == expected; ++itr ) ;
-
-		return success( itr == grid.cend() );
+		return success(grid_algebra::all_equal(grid, expected));
 	}
 };
 
@@ -0,0 +1,69 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <iostream>
+
+#include "general.h"
+#include "pipeline.h"
+
+class MyProgram : public Program
+{
+	exit_t main()
+	{
+		assert_usage(argc >= 2);
+
+		pipeline::pipeline_t pipe;
+		for(int i = 1; i < argc; ++i)
+		 pipe.add(argv[i]);
+
+		pipe.run(std::cin, std::cout);
+		pipe.print_timings(std::cerr);
+
+		return exit_t::success;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	HelpStruct help;
+	help.syntax = "core/pipeline <stage> [<stage> ...]";
+	help.description = "Runs a chain of programs in one process, "
+		"passing the grids without text conversion.\n"
+		"Each stage is one parameter, e.g.:\n"
+		"core/pipeline \"create 64 64\" \"random_throw 10000 42\" "
+		"\"comb sub id 64 64\" to_tga\n"
+		"Supported stages:\n"
+		"create <width> <height> [<initial>]\n"
+		"id <width> <height>\n"
+		"read [<file>]\n"
+		"fix\n"
+		"random_throw <number> <seed>\n"
+		"comb add|sub|mul|min|max <source stage>\n"
+		"to_tga [<min_color> <max_color> [<min_val> <max_val> [<outfile>]]]\n"
+		"write [<file>]";
+	help.input = "input grid, if the first stage is no source "
+		"(create, id, read)";
+	help.output = "the resulting grid, if the last stage is no sink "
+		"(to_tga, write). Timings for each stage are written to stderr.";
+	help.add_param("stage", "name of a stage and its parameters");
+
+	MyProgram p;
+	return p.run(argc, argv, &help);
+}
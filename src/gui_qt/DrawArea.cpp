@@ -18,7 +18,6 @@
 /* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
 /*************************************************************************/
 
-#include <QProgressDialog>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPaintEvent>
@@ -35,13 +34,17 @@ DrawArea::DrawArea(StateMachine& _state_machine, sca::ca::input_ca* ca, QWidget
 	TIMER_INTERVAL(250),
 	min_color(0,255,0),
 	max_color(255,0,0),
-	ca(ca),
-	grid_layout(this)
+	ca(ca)
 {
 	set_timeout_interval(TIMER_INTERVAL);
-
-	connect(&next_fire_timer, SIGNAL(timeout()),
-		this, SLOT(slot_timeout()));
+	frame_timer.setInterval(FRAME_INTERVAL);
+
+	connect(&frame_timer, SIGNAL(timeout()),
+		this, SLOT(slot_frame()));
+	connect(&sim, SIGNAL(stepped()),
+		this, SLOT(slot_stepped()));
+	connect(&sim, SIGNAL(stabilized()),
+		this, SLOT(slot_stabilized()));
 	connect(&state_machine, SIGNAL(updated(StateMachine::STATE)),
 		this, SLOT(state_updated(StateMachine::STATE)));
 
@@ -54,21 +57,13 @@ DrawArea::DrawArea(StateMachine& _state_machine, sca::ca::input_ca* ca, QWidget
 		itr->to_32bit((int*)(color_table + entry));
 	}
 	color_table[8] = 0; // sentinel - black
-
-	pixmap_table.resize(9);
 	for(int i = 0; i < 9; ++i)
-	{
-		pixmap_table[i] = QPixmap(1, 1);
-		pixmap_table[i].fill(color_table[i]);
-	}
-
+	 color_table[i] |= 0xff000000; // opaque
 }
 
 DrawArea::~DrawArea()
 {
-	// delete grid_image;
-	for(int i = 0; i < labels.size(); ++i)
-	 delete labels[i];
+	release_ca();
 
 	// make program output
 	std::cout << ca->grid();
@@ -77,36 +72,77 @@ DrawArea::~DrawArea()
 
 void DrawArea::set_pixel_size(int pixel_size) {
 	pixel_factor = pixel_size;
-	update_pixmap();
+	setMinimumSize(sizeHint());
+	update();
 }
 
-void DrawArea::slot_timeout()
+QSize DrawArea::sizeHint() const
 {
-	for(const point& p : recent_active_cells)
-	{
-		int coord = p.y * ca->grid().human_dim().width() + p.x;
-		labels[coord]->setPixmap(&pixmap_of(ca->grid()[p]));
-	}
-	recent_active_cells = ca->active_cells();
+	return image.size() * pixel_factor;
+}
+
+void DrawArea::paintEvent(QPaintEvent* event)
+{
+	// draw the part of the scaled image which needs an update
+	const QRect& target = event->rect();
+	const QRect source = QRect(target.x() / pixel_factor,
+		target.y() / pixel_factor,
+		target.width() / pixel_factor + 2,
+		target.height() / pixel_factor + 2).intersected(image.rect());
+	QPainter painter(this);
+	painter.drawImage(QRect(source.topLeft() * pixel_factor,
+		source.size() * pixel_factor), image, source);
+}
+
+void DrawArea::mousePressEvent(QMouseEvent* event)
+{
+	const point p(event->x() / pixel_factor, event->y() / pixel_factor);
+	if(ca && ca_info.dim.contains(p))
+	 onMousePressed(p);
+}
 
-	if(ca->has_active_cells())
-	 ca->run_once();
-	else {
-		next_fire_timer.stop();
-		state_machine.set(StateMachine::STATE_STABLE);
+void DrawArea::slot_frame()
+{
+	sim.fetch(fetched_cells, fetched_states);
+	if(fetched_cells.empty())
+	 return;
+
+	int x0 = image.width(), y0 = image.height(), x1 = -1, y1 = -1;
+	for(std::size_t i = 0; i < fetched_cells.size(); ++i)
+	{
+		const point& p = fetched_cells[i];
+		reinterpret_cast<QRgb*>(image.scanLine(p.y))[p.x] =
+			color_of(fetched_states[i]);
+		x0 = std::min(x0, (int)p.x);
+		y0 = std::min(y0, (int)p.y);
+		x1 = std::max(x1, (int)p.x);
+		y1 = std::max(y1, (int)p.y);
 	}
+	update(x0 * pixel_factor, y0 * pixel_factor,
+		(x1 - x0 + 1) * pixel_factor, (y1 - y0 + 1) * pixel_factor);
+}
 
+void DrawArea::slot_stepped()
+{
 	if(state_machine.get() == StateMachine::STATE_STEP)
 	 state_machine.set(StateMachine::STATE_INSTABLE);
 }
 
+void DrawArea::slot_stabilized()
+{
+	// the last changes might not have been drawn yet
+	slot_frame();
+	state_machine.set(StateMachine::STATE_STABLE);
+}
+
 void DrawArea::update_pixmap()
 {
-	for(const point& p : ca->grid().points())
-	{
-		int coord = p.y * ca->grid().human_dim().width() + p.x;
-		labels[coord]->setPixmap(&pixmap_of(ca->grid()[p]));
-	}
+	ca_info = sim.set_ca(ca); // marks all cells dirty
+	image = QImage(ca_info.dim.width(), ca_info.dim.height(),
+		QImage::Format_RGB32);
+	slot_frame();
+	setMinimumSize(sizeHint());
+	update();
 }
 
 void DrawArea::state_updated(StateMachine::STATE new_state)
@@ -114,14 +150,13 @@ void DrawArea::state_updated(StateMachine::STATE new_state)
 	switch(new_state)
 		{
 		case StateMachine::STATE_STEP:
-			QTimer::singleShot(TIMER_INTERVAL,
-				this, SLOT(slot_timeout()));
+			sim.step();
 			break;
 		case StateMachine::STATE_INSTABLE:
-			next_fire_timer.stop();
+			sim.pause();
 			break;
 		case StateMachine::STATE_SIMULATING:
-			next_fire_timer.start();
+			sim.resume();
 			break;
 		default: break;
 		}
@@ -135,16 +170,10 @@ void DrawArea::onMousePressed(point coords)
 		//|| state == StateMachine::STATE_WELCOME
 		|| state == StateMachine::STATE_STABLE_PAUSED)
 	{
-		ca->input(coords);
-
-		int coord = coords.y * ca->grid().human_dim().width() + coords.x;
-		labels[coord]->setPixmap(&pixmap_of(ca->grid()[coords]));
+		// the thread applies the input, the frame timer draws it
+		sim.input(coords);
 
 		state_machine.trigger_throw();
-		if(state_machine.get() != StateMachine::STATE_INSTABLE)
-		{
-			next_fire_timer.start();
-		}
 	}
 }
 
@@ -153,39 +182,29 @@ void DrawArea::fill_grid(std::istream &inf)
 	ca->grid() = grid_t(inf, ca->border_width());
 	ca->finalize();
 
-	labels.resize(ca->grid().human_dim().area());
-	for(const point& p : ca->grid().points())
-	{
-		int idx = p.y * ca->grid().human_dim().width() + p.x;
-		labels[idx] = new ImgContainer(parentWidget(), p);
-		grid_layout.addWidget(labels[idx], p.y, p.x);
-		QObject::connect(labels[idx], SIGNAL(clicked(point)),
-			this, SLOT(onMousePressed(point)));
-	}
-
 	// TODO: redundant -> see reset_ca()
 	update_pixmap();
+	sim.start();
+	frame_timer.start();
 	state_machine.trigger_throw();
-	/*if(state_machine.get() != StateMachine::STATE_INSTABLE)
-	{
-		next_fire_timer.start();
-	}*/
+}
+
+void DrawArea::release_ca()
+{
+	sim.set_ca(nullptr);
 }
 
 void DrawArea::on_reset_ca(sca::ca::input_ca *new_ca)
 {
 	ca = new_ca;
 
-	update_pixmap(); // TODO: useless?
+	update_pixmap();
 	state_machine.trigger_throw();
-	if(state_machine.get() != StateMachine::STATE_INSTABLE)
-	{
-		next_fire_timer.start();
-	}
+	if(state_machine.get() == StateMachine::STATE_SIMULATING)
+	 sim.resume();
 }
 
 void DrawArea::set_timeout_interval(int msecs) {
 	TIMER_INTERVAL = msecs;
-	next_fire_timer.setInterval(TIMER_INTERVAL);
+	sim.set_interval(TIMER_INTERVAL);
 }
-
@@ -22,13 +22,14 @@
 #define DRAWAREA_H
 
 #include <iostream>
-#include <QLabel>
+#include <vector>
+#include <QImage>
 #include <QTimer>
-#include <QGridLayout>
+#include <QWidget>
 
 #include "geometry.h"
 #include "StateMachine.h"
-#include "labeled_widget.h"
+#include "SimThread.h"
 #include "image.h"
 
 namespace sca { namespace ca {
@@ -41,36 +42,9 @@ namespace sca { namespace ca {
 	class _array_queue_no_file;
 }*/
 
-//! This will be hold for every cell
-class ImgContainer : public QLabel
-{
-	Q_OBJECT
-	const QPixmap* pixmap;
-	point coords;
-	void update_pixmap() {
-		QLabel::setPixmap(pixmap->scaled(
-			width(),
-			height(), Qt::KeepAspectRatio));
-	}
-
-	void mousePressEvent(QMouseEvent *) {
-		emit clicked(coords);
-	}
-public:
-	ImgContainer(QWidget* parent, const point& coords) :
-		QLabel(parent), coords(coords) {}
-	void setPixmap ( const QPixmap * _pixmap ) {
-		pixmap = _pixmap;
-		update_pixmap();
-	}
-	void resizeEvent(QResizeEvent *) {
-		update_pixmap();
-	}
-signals:
-	void clicked(point);
-};
-
 //! This widget displays the grid
+//! The simulation runs in a SimThread. Frames are drawn at a fixed
+//! rate, only converting the cells which changed into the image.
 class DrawArea : public QWidget
 {
 	Q_OBJECT
@@ -79,36 +53,42 @@ class DrawArea : public QWidget
 
 	int pixel_factor;
 	int TIMER_INTERVAL;
+	static constexpr int FRAME_INTERVAL = 16; //!< ms, about 60 fps
 
 	rgb min_color, max_color;
 
 	QRgb color_table[9]; // 0 to 7 + sentinel
-	inline const QPixmap& pixmap_of(int state) const {
-		return pixmap_table[std::min((unsigned)state, 8u)];
+	inline QRgb color_of(int state) const {
+		return color_table[std::min((unsigned)state, 8u)];
 	}
 
-	QVector<QPixmap> pixmap_table;
-	QVector<ImgContainer*> labels;
-
-	void increase_cell(const point& coord, int steps);
-	void fire_cell(int coords);
+	QImage image; //!< one pixel per cell
 
 //	unsigned int next_cell;
 //	int current_hint;
 //	point current_hint;
 //	sandpile::_array_queue_no_file<int*>* container;
-	QTimer next_fire_timer;
+	QTimer frame_timer;
 	sca::ca::input_ca* ca = nullptr;
+	SimThread sim;
+	//! info about ca, the ca itself is only accessed through sim
+	SimThread::ca_info_t ca_info;
 
-	std::vector<point> recent_active_cells;
+	//! cells fetched from sim, and their states
+	std::vector<point> fetched_cells;
+	std::vector<int> fetched_states;
 
-	QGridLayout grid_layout;
-	//QVector<QImage> imgs;
+	void paintEvent(QPaintEvent* event);
+	void mousePressEvent(QMouseEvent* event);
+	QSize sizeHint() const;
 
 private slots:
-	void slot_timeout();
+	//! draws the cells changed since the last frame
+	void slot_frame();
+	void slot_stepped();
+	void slot_stabilized();
 
-	//! updates the whole pixmaps from the whole grid
+	//! updates the whole image from the whole grid
 	void update_pixmap();
 	void state_updated(StateMachine::STATE new_state);
 
@@ -122,7 +102,11 @@ public:
 
 	void set_pixel_size(int pixel_size);
 	void fill_grid(std::istream& inf = std::cin);
+	//! stops using the current ca, e.g. before deleting it
+	void release_ca();
 	void on_reset_ca(sca::ca::input_ca* new_ca);
+	//! whether the ca could run when it was set
+	bool can_run() const { return ca_info.can_run; }
 
 public slots:
 	void set_timeout_interval(int msecs);
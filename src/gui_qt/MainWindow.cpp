@@ -108,7 +108,7 @@ MainWindow::MainWindow(const char *ca_eq, const char *input_eq, QWidget *parent)
 	setup_ui();
 	retranslate_ui();
 	state_machine.set(StateMachine::STATE_STABLE);
-	state_machine.set(ca->can_run() ? StateMachine::STATE_INSTABLE
+	state_machine.set(draw_area.can_run() ? StateMachine::STATE_INSTABLE
 				: StateMachine::STATE_STABLE);
 }
 
@@ -158,6 +158,7 @@ void MainWindow::change_ca_type()
 	ca_sel.setModal(true);
 	if(ca_sel.exec() == QDialog::Accepted)
 	{
+		draw_area.release_ca();
 		grid_t grid_copy = std::move(ca->grid());
 		delete ca;
 		ca = ca_sel.instantiate_ca();
@@ -165,7 +166,7 @@ void MainWindow::change_ca_type()
 		ca->finalize();
 
 		draw_area.on_reset_ca(ca);
-		state_machine.set(ca->can_run() ? StateMachine::STATE_INSTABLE
+		state_machine.set(draw_area.can_run() ? StateMachine::STATE_INSTABLE
 					: StateMachine::STATE_STABLE);
 	}
 }
@@ -0,0 +1,210 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <chrono>
+
+#include "SimThread.h"
+#include "ca.h"
+
+SimThread::~SimThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	cond.notify_all();
+	wait();
+}
+
+void SimThread::publish(const std::vector<point>& cells)
+{
+	std::lock_guard<std::mutex> lock(front_mutex);
+	const grid_t& grid = ca->grid();
+	for(const point& p : cells)
+	{
+		const std::size_t idx = p.y * width + p.x;
+		front[idx] = grid[p];
+		if(!is_dirty[idx])
+		{
+			is_dirty[idx] = 1;
+			dirty.push_back(p);
+		}
+	}
+}
+
+void SimThread::run()
+{
+	using clock = std::chrono::steady_clock;
+	clock::time_point last_round = clock::now();
+	for(;;)
+	{
+		// wait for inputs or for the next round, without holding the ca
+		bool run_round;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			for(;;)
+			{
+				if(quit)
+				 return;
+				const clock::time_point due = last_round
+					+ std::chrono::milliseconds(interval);
+				run_round = ca && steps && clock::now() >= due;
+				if(run_round || !pending.empty())
+				 break;
+				else if(ca && steps)
+				 cond.wait_until(lock, due);
+				else
+				 cond.wait(lock);
+			}
+			inputs.swap(pending);
+		}
+
+		std::lock_guard<std::mutex> ca_lock(ca_mutex);
+		if(!ca) // set_ca(nullptr) was called meanwhile
+		{
+			inputs.clear();
+			continue;
+		}
+
+		for(const point& p : inputs)
+		 ca->input(p);
+		publish(inputs);
+		inputs.clear();
+
+		if(!run_round)
+		 continue;
+		else if(!ca->has_active_cells())
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				steps = 0;
+			}
+			emit stabilized();
+			continue;
+		}
+
+		// the ca is one round ahead: the next round writes the out
+		// neighbourhoods of the active cells
+		changed.clear();
+		ca->get_next_written(changed);
+		ca->run_once();
+		publish(changed);
+
+		bool done;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			done = steps > 0 && !--steps;
+			last_round = clock::now();
+		}
+		if(done)
+		 emit stepped();
+	}
+}
+
+SimThread::ca_info_t SimThread::set_ca(sca::ca::input_ca* new_ca)
+{
+	ca_info_t info;
+	std::lock_guard<std::mutex> ca_lock(ca_mutex);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ca = new_ca;
+		steps = 0;
+		pending.clear();
+	}
+	if(ca)
+	{
+		info.dim = ca->grid().human_dim();
+		info.can_run = ca->can_run();
+		{
+			std::lock_guard<std::mutex> front_lock(front_mutex);
+			width = info.dim.width();
+			front.assign(info.dim.area(), 0);
+			is_dirty.assign(info.dim.area(), 0);
+			dirty.clear();
+		}
+		std::vector<point> all;
+		for(const point& p : ca->grid().points())
+		 all.push_back(p);
+		publish(all);
+	}
+	cond.notify_all();
+	return info;
+}
+
+void SimThread::resume()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		steps = -1;
+	}
+	cond.notify_all();
+}
+
+void SimThread::pause()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		steps = 0;
+	}
+	cond.notify_all();
+}
+
+void SimThread::step()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		steps = 1;
+	}
+	cond.notify_all();
+}
+
+void SimThread::set_interval(int msecs)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		interval = msecs;
+	}
+	cond.notify_all();
+}
+
+void SimThread::input(const point& p)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(!ca)
+		 return;
+		pending.push_back(p);
+	}
+	cond.notify_all();
+}
+
+void SimThread::fetch(std::vector<point>& cells, std::vector<int>& states)
+{
+	cells.clear();
+	std::lock_guard<std::mutex> lock(front_mutex);
+	cells.swap(dirty);
+	states.resize(cells.size());
+	for(std::size_t i = 0; i < cells.size(); ++i)
+	{
+		const std::size_t idx = cells[i].y * width + cells[i].x;
+		states[i] = front[idx];
+		is_dirty[idx] = 0;
+	}
+}
@@ -0,0 +1,117 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include <QThread>
+
+#include "geometry.h"
+
+namespace sca { namespace ca {
+	class input_ca;
+} }
+
+/**
+ * @brief Runs the simulation in a background thread.
+ *
+ * The simulator's grid is the back buffer. After each round, the
+ * states of the changed cells are copied into the front buffer, and
+ * the cells are marked as dirty. The GUI thread fetches only the dirty
+ * cells, so neither thread has to wait for the other to copy or draw
+ * whole grids.
+ */
+class SimThread : public QThread
+{
+	Q_OBJECT
+
+	//! protects the ca, held by the thread while it runs a round
+	//! @note lock order: ca_mutex before mutex
+	std::mutex ca_mutex;
+	//! written with ca_mutex and mutex held, so holding one suffices
+	//!   for reading
+	sca::ca::input_ca* ca = nullptr;
+
+	//! protects the control variables below, only held shortly
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool quit = false;
+	int steps = 0; //!< rounds to run, -1 means until paused
+	int interval = 0; //!< milliseconds between two rounds
+	std::vector<point> pending; //!< inputs not yet applied to the ca
+
+	//! protects the front buffer
+	std::mutex front_mutex;
+	int width = 0;
+	std::vector<int> front; //!< states of the cells, row by row
+	std::vector<point> dirty; //!< cells changed since the last fetch
+	std::vector<char> is_dirty;
+
+	std::vector<point> changed, inputs; //!< temporaries of the thread
+
+	//! copies the states of @a cells from the ca into the front buffer
+	void publish(const std::vector<point>& cells);
+
+	void run() override;
+
+signals:
+	//! emitted when a round was run because of step()
+	void stepped();
+	//! emitted when there are no more active cells
+	void stabilized();
+
+public:
+	explicit SimThread(QObject* parent = nullptr) : QThread(parent) {}
+	~SimThread();
+
+	//! what the GUI thread needs to know about a ca. the GUI thread
+	//!   must not access the ca itself while the thread may run
+	struct ca_info_t
+	{
+		dimension dim = dimension(0, 0);
+		bool can_run = false; //!< see input_ca::can_run()
+	};
+
+	//! sets a new ca and marks all cells dirty, @a new_ca may be
+	//!   nullptr. waits for a running round to end, the old ca is not
+	//!   used anymore after this call
+	//! @return info about @a new_ca, read before any round runs on it
+	ca_info_t set_ca(sca::ca::input_ca* new_ca);
+
+	//! runs rounds until pause() is called
+	void resume();
+	void pause();
+	//! runs one round
+	void step();
+	void set_interval(int msecs);
+
+	//! applies the ca's input function at @a p in the thread,
+	//!   before the next round
+	void input(const point& p);
+
+	//! moves the cells changed since the last call into @a cells and
+	//!   their states into @a states
+	void fetch(std::vector<point>& cells, std::vector<int>& states);
+};
+
+#endif // SIMTHREAD_H
@@ -8,8 +8,8 @@ DEPENDPATH += .
 INCLUDEPATH += . ../res
 
 # Input
-HEADERS += MainWindow.h DrawArea.h StateMachine.h MenuBar.h \
+HEADERS += MainWindow.h DrawArea.h StateMachine.h MenuBar.h SimThread.h \
 	../res/io.h ../res/image.h
-SOURCES += main.cpp MainWindow.cpp DrawArea.cpp StateMachine.cpp \
+SOURCES += main.cpp MainWindow.cpp DrawArea.cpp StateMachine.cpp SimThread.cpp \
 	MenuBar.cpp \
 	../res/io.cpp ../res/image.cpp
@@ -20,86 +20,196 @@
 
 #include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <string>
+#ifdef USE_IMAGEMAGICK
 #include <Magick++/Blob.h>
 #include <Magick++/Image.h>
+#endif
 
 #include "general.h"
 #include "geometry.h"
+#include "image.h"
 #include "ca.h"
 #include "ca_eqs.h"
+#include "ca/tiled_transform.h"
 
-std::vector<char> get_file_contents(std::istream& stream = std::cin)
+using calc_t = sca::ca::_calculator_t<
+	sca::ca::eqsolver_t, def_coord_traits, def_cell_traits>;
+
+//! maps pixels of a PAM to ints and back, like ImageMagick does for
+//!   a format string like "ARGB": the first channel is the highest byte
+class pixel_format_t
 {
-	int RD_BUF_SIZE = 128;
-	char rdbuf[RD_BUF_SIZE];
-	std::vector<char> contents;
-	bool eof_hit;
-	do
+	int shift[4]; //!< for R, G, B, A, or -1 if not in the format
+	const int depth;
+
+	static int channel_id(char c)
 	{
-		eof_hit = ! stream.read(rdbuf, RD_BUF_SIZE);
-		contents.insert(contents.end(),
-			rdbuf, rdbuf + stream.gcount());
-	} while(!eof_hit) ;
-	return contents;
-}
+		switch(c)
+		{
+			case 'R': return 0;
+			case 'G': return 1;
+			case 'B': return 2;
+			case 'A': return 3;
+			default: throw "PAM images only support the channels RGBA.";
+		}
+	}
+public:
+	pixel_format_t(const std::string& format, int depth) : depth(depth)
+	{
+		std::fill(shift, shift + 4, -1);
+		for(std::size_t i = 0; i < 4; ++i)
+		 shift[channel_id(format[i])] = (3 - i) << 3;
+	}
+
+	int to_int(const unsigned char* px) const
+	{
+		unsigned char ch[4] = { 0, 0, 0, 255 };
+		switch(depth)
+		{
+			case 1: ch[0] = ch[1] = ch[2] = px[0]; break;
+			case 2: ch[0] = ch[1] = ch[2] = px[0]; ch[3] = px[1]; break;
+			default: std::copy(px, px + depth, ch);
+		}
+		unsigned res = 0;
+		for(int c = 0; c < 4; ++c)
+		if(shift[c] >= 0)
+		 res |= (unsigned)ch[c] << shift[c];
+		return (int)res;
+	}
+
+	void from_int(int val, unsigned char* px) const
+	{
+		unsigned char ch[4] = { 0, 0, 0, 255 };
+		for(int c = 0; c < 4; ++c)
+		if(shift[c] >= 0)
+		 ch[c] = ((unsigned)val >> shift[c]) & 0xFF;
+		switch(depth)
+		{
+			case 1: px[0] = ch[0]; break;
+			case 2: px[0] = ch[0]; px[1] = ch[3]; break;
+			default: std::copy(ch, ch + depth, px);
+		}
+	}
+};
 
 class MyProgram : public Program
 {
-	exit_t main()
+	const char *equation = "v";
+	int iterations = 1;
+
+	//! runs the CA on the whole image, for CAs which write to cells
+	//!   other than v
+	void run_simulator(std::vector<int>& pixels, const dimension& dim) const
 	{
-		const char *equation = "v";
-		std::string format = "ARGB";
-		int iterations = 1;
+		using ca_sim_t = sca::ca::simulator_t<
+			sca::ca::eqsolver_t, def_coord_traits, def_cell_traits>;
+		ca_sim_t sim(equation);
+		grid_t grid(dim, 0);
+		std::copy(pixels.begin(), pixels.end(), grid.data().begin());
+		sim.grid() = grid;
+		sim.finalize();
 
-		MagickCore::MagickCoreGenesis(*argv, Magick::MagickFalse);
+		for(int i = 0; i < iterations; ++i)
+		 sim.run_once(ca_sim_t::synchronous());
 
-		switch(argc)
+		std::copy(sim.grid().data().begin(), sim.grid().data().end(),
+			pixels.begin());
+	}
+
+	//! runs the CA on an image in memory
+	void run_in_memory(const calc_t& calc, std::vector<int>& pixels,
+		const dimension& dim) const
+	{
+		if(!sca::ca::tiled_transform_t<sca::ca::eqsolver_t,
+			def_coord_traits, def_cell_traits>::supports(calc))
 		{
-			case 4:
-				iterations = atoi(argv[3]);
-			case 3:
-				format = argv[2];
-				assert_always(format.length()==4, "Format must consist of 4 chars.");
-				// TODO: only RGBACYMK allowed
-			case 2:
-				equation = argv[1];
-				break;
-			case 1:
-			default:
-				exit_usage();
+			run_simulator(pixels, dim);
+			return;
 		}
+
+		sca::ca::tiled_transform_t<sca::ca::eqsolver_t,
+			def_coord_traits, def_cell_traits> transform(calc, iterations);
+		const int* src = pixels.data();
+		std::vector<int> res(pixels.size());
+		int* tar = res.data();
+		transform(dim,
+			[&](int* rows, int n) {
+				std::copy(src, src + n * dim.dx(), rows);
+				src += n * dim.dx(); },
+			[&](const int* rows, int n) {
+				tar = std::copy(rows, rows + n * dim.dx(), tar); });
+		pixels = std::move(res);
+	}
+
+	//! streams a PAM from stdin to stdout, without ImageMagick
+	void transform_pam(const calc_t& calc, const std::string& format) const
+	{
+		const pam::header_t hdr = pam::read_header(std::cin, true);
+		const dimension dim(hdr.width, hdr.height);
+		const pixel_format_t pf(format, hdr.depth);
+		const std::size_t row_bytes = hdr.width * hdr.depth;
+		std::vector<unsigned char> buf;
+
+		const auto read_rows = [&](int* rows, int n) {
+			buf.resize(n * row_bytes);
+			if(!std::cin.read((char*)buf.data(), buf.size()))
+			 throw "PAM image is truncated.";
+			for(std::size_t i = 0; i < (std::size_t)n * hdr.width; ++i)
+			 rows[i] = pf.to_int(buf.data() + i * hdr.depth);
+		};
+		const auto write_rows = [&](const int* rows, int n) {
+			buf.resize(n * row_bytes);
+			for(std::size_t i = 0; i < (std::size_t)n * hdr.width; ++i)
+			 pf.from_int(rows[i], buf.data() + i * hdr.depth);
+			std::cout.write((const char*)buf.data(), buf.size());
+		};
+
+		pam::write_header(std::cout, hdr);
+		if(sca::ca::tiled_transform_t<sca::ca::eqsolver_t,
+			def_coord_traits, def_cell_traits>::supports(calc))
+		{
+			sca::ca::tiled_transform_t<sca::ca::eqsolver_t,
+				def_coord_traits, def_cell_traits>
+				transform(calc, iterations);
+			transform(dim, read_rows, write_rows);
+		}
+		else
+		{
+			std::vector<int> pixels(dim.area());
+			read_rows(pixels.data(), dim.dy());
+			run_simulator(pixels, dim);
+			write_rows(pixels.data(), dim.dy());
+		}
+	}
+
+#ifdef USE_IMAGEMAGICK
+	void transform_magick(const calc_t& calc, std::string format,
+		const std::string& magic) const
+	{
 		// big endian -> reverse format for user
 		std::reverse(format.begin(), format.end());
 
-		std::vector<char> content = get_file_contents();
+		const std::string content = magic + std::string(
+			std::istreambuf_iterator<char>(std::cin),
+			std::istreambuf_iterator<char>());
 
 		try {
-
-			// this is all much copying,
-			// but it seems to be the only way...
 			Magick::Blob blob(content.data(), content.size());
 			Magick::Image img(blob);
 
 			const dimension dim(img.size().width(),
 				img.size().height());
-			grid_t grid(dimension(dim.height(), dim.width()), 0);
+			std::vector<int> pixels(dim.area());
 			img.write(0, 0, dim.width(), dim.height(), format,
-				Magick::CharPixel, grid.data().data());
-
-
-			using ca_sim_t = sca::ca::simulator_t<
-				sca::ca::eqsolver_t, def_coord_traits, def_cell_traits>;
-			ca_sim_t sim(equation);
-			sim.grid() = grid;
-			sim.finalize();
+				Magick::CharPixel, pixels.data());
 
-
-			for(int i = 0; i < iterations; ++i)
-			 sim.run_once(ca_sim_t::synchronous());
+			run_in_memory(calc, pixels, dim);
 
 			Magick::Blob blob2;
 			Magick::Image img2(dim.width(), dim.height(), format,
-				Magick::CharPixel, sim.grid().data().data());
+				Magick::CharPixel, pixels.data());
 			// needed, otherwise we write "format-less":
 			img2.magick(img.magick());
 			img2.write(&blob2);
@@ -110,6 +220,50 @@ class MyProgram : public Program
 			std::cerr << "Caught Magick++ exception: "
 				<< error.what() << std::endl;
 		}
+	}
+#endif
+
+	exit_t main()
+	{
+		std::string format = "ARGB";
+
+#ifdef USE_IMAGEMAGICK
+		MagickCore::MagickCoreGenesis(*argv, Magick::MagickFalse);
+#endif
+
+		switch(argc)
+		{
+			case 4:
+				iterations = atoi(argv[3]);
+			case 3:
+				format = argv[2];
+				assert_always(format.length()==4, "Format must consist of 4 chars.");
+				// TODO: only RGBACYMK allowed
+			case 2:
+				equation = argv[1];
+				break;
+			case 1:
+			default:
+				exit_usage();
+		}
+
+		const calc_t calc(equation);
+
+		std::string magic(2, 0);
+		std::cin.read(&magic[0], 2);
+		magic.resize(std::cin.gcount());
+
+		if(magic == "P7")
+		 transform_pam(calc, format);
+		else
+		{
+#ifdef USE_IMAGEMAGICK
+			transform_magick(calc, format, magic);
+#else
+			throw "Input is no PAM image, and img/transform "
+				"has been built without ImageMagick.";
+#endif
+		}
 
 		return exit_t::success;
 	}
@@ -119,7 +273,9 @@ int main(int argc, char** argv)
 {
 	HelpStruct help;
 	help.syntax = "img/transform <equation> [<format> [<iterations>]]";
-	help.description = "Transforms given image using a CA\n";
+	help.description = "Transforms given image using a CA\n"
+		"PAM images (P7) are streamed through the CA in bands of rows.\n"
+		"Other formats need ImageMagick support.";
 	help.input = "input image";
 	help.output = "output image";
 	help.add_param("<equation>", "transformation equation");
@@ -128,6 +284,3 @@ int main(int argc, char** argv)
 	MyProgram p;
 	return p.run(argc, argv, &help);
 }
-
-
-
@@ -0,0 +1,236 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cctype>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "general.h"
+#include "image.h"
+#include "grid.h"
+
+class MyProgram : public Program
+{
+	std::unique_ptr<frame_writer_t> writer;
+	const char* outfile = nullptr;
+	bool file_per_frame = false; //!< if outfile is a pattern
+	FILE* single_fp = nullptr; //!< if all frames go to one file
+	std::size_t frame = 0;
+
+	std::vector<unsigned char> idx; //!< palette indices of a row or frame
+	std::vector<int> cells; //!< one row of a binary grid
+
+	//! whether @a pattern has exactly one conversion, which must be
+	//!   like %d or %05d, so it can be passed to printf with one int
+	static bool valid_pattern(const char* pattern)
+	{
+		int conversions = 0;
+		for(const char* ptr = pattern; (ptr = strchr(ptr, '%')); )
+		if(*++ptr == '%')
+		 ++ptr;
+		else
+		{
+			for(; *ptr && strchr("-+ 0", *ptr); ++ptr) ;
+			for(int digits = 0; isdigit(*ptr); ++ptr)
+			if(++digits > 3)
+			 return false;
+			if(*ptr != 'd' && *ptr != 'i')
+			 return false;
+			++conversions;
+		}
+		return conversions == 1;
+	}
+
+	//! returns the file for the next frame
+	FILE* open_frame()
+	{
+		if(!outfile || !strcmp(outfile, "-"))
+		 return stdout;
+		else if(file_per_frame)
+		{
+			// the pattern has been checked by valid_pattern()
+			char name[4096];
+			snprintf(name, sizeof(name), outfile, (int)frame);
+			FILE* fp = fopen(name, "wb");
+			if(!fp)
+			 throw "Error opening outfile";
+			return fp;
+		}
+		else
+		{
+			// all frames in one file
+			if(!single_fp && !(single_fp = fopen(outfile, "wb")))
+			 throw "Error opening outfile";
+			return single_fp;
+		}
+	}
+
+	void close_frame(FILE* fp)
+	{
+		if(file_per_frame)
+		 fclose(fp);
+		++frame;
+	}
+
+	//! reads the next text grid, which ends at an empty line or at EOF
+	//! since the height is only known at the end, the frame's palette
+	//!   indices are buffered
+	bool text_frame(const palette_t& palette)
+	{
+		std::string line;
+		int width = -1, height = 0;
+		idx.clear();
+		while(std::getline(std::cin, line) && !line.empty())
+		{
+			const char* ptr = line.c_str();
+			char* end;
+			int col_count = 0;
+			for(long v = strtol(ptr, &end, 10); end != ptr;
+				v = strtol(ptr = end, &end, 10), ++col_count)
+			 idx.push_back(palette.index(v));
+			if(width < 0)
+			 width = col_count;
+			else if(width != col_count)
+			 throw "All lines of a grid must have the same length.";
+			++height;
+		}
+		if(!height)
+		 return false;
+
+		FILE* fp = open_frame();
+		writer->begin(fp, dimension(width, height));
+		for(int y = 0; y < height; ++y)
+		 writer->row(fp, idx.data() + y * width);
+		writer->end(fp);
+		close_frame(fp);
+		return true;
+	}
+
+	//! reads the next binary grid, as written by io::serializer, and
+	//!   writes it row by row
+	bool binary_frame(const palette_t& palette)
+	{
+		if(std::cin.peek() == EOF)
+		 return false;
+
+		grid_alignment_t<def_coord_traits> align(0);
+		std::size_t size;
+		deserializer des(std::cin);
+		des >> align >> size;
+		const dimension& idim = align.internal_dim();
+		const int bw = align.border_width(), w = align.dx();
+		if(!std::cin || size != idim.area())
+		 throw "Invalid binary grid.";
+
+		FILE* fp = open_frame();
+		writer->begin(fp, align.human_dim());
+		cells.resize(idim.dx());
+		idx.resize(w);
+		for(int y = 0; y < (int)idim.dy(); ++y)
+		{
+			if(!std::cin.read((char*)cells.data(),
+				cells.size() * sizeof(int)))
+			 throw "Binary grid is truncated.";
+			if(y >= bw && y < (int)idim.dy() - bw)
+			{
+				for(int x = 0; x < w; ++x)
+				 idx[x] = palette.index(cells[x + bw]);
+				writer->row(fp, idx.data());
+			}
+		}
+		writer->end(fp);
+		close_frame(fp);
+		return true;
+	}
+
+	exit_t main()
+	{
+		rgb min_color(255,255,255), max_color(0,0,0);
+		int min_val=0, max_val=3;
+		const char* format = nullptr;
+		bool binary = false;
+		switch(argc)
+		{
+			case 8: outfile = argv[7];
+			case 7: max_val = atoi(argv[6]);
+			case 6: min_val = atoi(argv[5]);
+			case 5: max_color.from_str(argv[4]);
+			case 4: min_color.from_str(argv[3]);
+			case 3:
+				assert_usage(!strcmp(argv[2], "text")
+					|| !strcmp(argv[2], "bin"));
+				binary = !strcmp(argv[2], "bin");
+				format = argv[1];
+				break;
+			default:
+				exit_usage();
+		}
+
+		if(outfile && strchr(outfile, '%'))
+		{
+			if(!valid_pattern(outfile))
+			 throw "The outfile pattern needs exactly one integer "
+				"conversion, like %05d (write %% for a %).";
+			file_per_frame = true;
+		}
+
+		const palette_t palette(ColorTable(min_color, max_color,
+			min_val, max_val));
+		writer.reset(frame_writer_t::make(format, palette));
+
+		std::ios_base::sync_with_stdio(false);
+		while(binary ? binary_frame(palette) : text_frame(palette)) ;
+
+		fflush(stdout);
+		if(single_fp)
+		 fclose(single_fp);
+
+		return exit_t::success;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	HelpStruct help;
+	help.syntax = "io/export <format> <input> [<min_color> <max_color> "
+		"[<min_val> <max_val> [<outfile>]]]";
+	help.description = "Converts a stream of grids to images, "
+		"one image per grid.\n"
+		"Images are written row by row, binary grids are also read "
+		"row by row.\n"
+		"Colors are interpolated like for io/to_tga.";
+	help.input = "input grids, text grids separated by empty lines";
+	help.output = "images if no outfile is given, otherwise nothing";
+	help.add_param("<format>", "tga (RLE compressed), pam or ppm");
+	help.add_param("<input>", "text, or bin for grids written by "
+		"the serializer");
+	help.add_param("<min_color>, <max_color>", "color values for min and max no of chips");
+	help.add_param("<min_val>, <max_val>", "modify min and max no of chips - default is 0 and 3");
+	help.add_param("<outfile>", "file to store all images in, - for "
+		"stdout, or a pattern like frame%05d.tga for one file per image, "
+		"with exactly one integer conversion");
+	MyProgram p;
+	return p.run(argc, argv, &help);
+}
@@ -101,8 +101,9 @@ class MyProgram : public Program
 		}
 		out << "};\n";
 #else
+		const std::vector<int32_t> colors = color_f(g);
 		const auto draw_node = [&](std::size_t x, std::size_t y) {
-			int32_t color_val = ((color_f(g, point(x, y))) & (0xFFFFFF));
+			int32_t color_val = colors[y * g.dx() + x] & 0xFFFFFF;
 			auto number = g[point(x, y)];
 			if(color_val)
 			out << (sca::io::color_formula_t::text_black(color_val) ? "\\cb{" : "\\cw{")
@@ -372,8 +373,8 @@ class MyProgram : public Program
 				if(has_grid)
 				{
 					const grid_t& g = grid;
-					for(const point& p : g.points())
-					 color_table.insert(the_color(g, p));
+					for(const int32_t& c : the_color(g))
+					 color_table.insert(c);
 				}
 
 #if 0
@@ -18,7 +18,9 @@
 /* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
 /*************************************************************************/
 
+#include <chrono>
 #include <iostream>
+#include <vector>
 
 #include "general.h"
 #include "io.h"
@@ -26,47 +28,81 @@
 
 class MyProgram : public Program
 {
+	//! number of values evaluated per call of the batch evaluator
+	static constexpr std::size_t block_size = 4096;
+
+	//! evaluates the formula for x = 0, ..., @a count - 1
+	//! and prints the throughput
+	static void bench(eqsolver::batch_evaluator& eval, std::size_t count)
+	{
+		std::vector<int> in(block_size), out(block_size);
+		long long checksum = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+		for(std::size_t done = 0; done < count; done += block_size)
+		{
+			const std::size_t n = std::min(block_size, count - done);
+			for(std::size_t i = 0; i < n; ++i)
+			 in[i] = (int)(done + i);
+			eval(in.data(), n, out.data());
+			for(std::size_t i = 0; i < n; ++i)
+			 checksum += out[i];
+		}
+		const std::chrono::duration<double> secs =
+			std::chrono::steady_clock::now() - start;
+
+		std::cout << "values: " << count << std::endl
+			<< "seconds: " << secs.count() << std::endl
+			<< "values/sec: " << (std::size_t)(count / secs.count())
+			<< std::endl
+			<< "checksum: " << checksum << std::endl;
+	}
+
 	exit_t main()
 	{
-		//FILE* read_fp = stdin;
 		std::istream& read_fp = std::cin;
 		const char* equation = "";
 		char separator = ' ';
+		std::size_t bench_count = 0;
 		switch(argc)
 		{
-			case 3: assert_usage(!strcmp(argv[2],"newlines"));
-				separator = '\n';
+			case 4: assert_usage(!strcmp(argv[2],"bench"));
+				bench_count = atoll(argv[3]);
+				assert_usage(bench_count > 0);
+				equation = argv[1];
+				break;
+			case 3: if(!strcmp(argv[2],"bench"))
+				 bench_count = 1 << 24;
+				else
+				{
+					assert_usage(!strcmp(argv[2],"newlines"));
+					separator = '\n';
+				}
 			case 2: equation = argv[1]; break;
 			default: exit_usage();
 		}
 		eqsolver::expression_ast ast;
 		eqsolver::build_tree(equation, &ast);
+		eqsolver::batch_evaluator eval(ast);
 
-//		int symbols_read;
-		int index;
 		sca_random::set_seed();
 
-#if 0
-		do {
-			/*symbols_read = fscanf(read_fp, "%d", &index);
-			if(symbols_read > 0) {
-				eqsolver::variable_print vprinter(index);
-				eqsolver::ast_print<eqsolver::variable_print> solver(&vprinter); // TODO: don't set x every time
-				fprintf(stdout, "%d%c", (int)solver(ast),separator);
-			}*/
-			read_fp >> index;
-			if(read_fp.good() > 0) {
-				eqsolver::variable_print vprinter(index);
-				eqsolver::ast_print<eqsolver::variable_print> solver(&vprinter); // TODO: don't set x every time
-				fprintf(stdout, "%d%c", (int)solver(ast),separator);
-			}
-		} while(read_fp.good() > 0);
-		#endif
-		while(read_fp >> index)
+		if(bench_count)
+		{
+			bench(eval, bench_count);
+			return exit_t::success;
+		}
+
+		std::vector<int> values(block_size);
+		bool good = true;
+		while(good)
 		{
-			eqsolver::variable_print vprinter(index);
-			eqsolver::ast_print<eqsolver::variable_print> solver(&vprinter); // TODO: don't set x every time
-			std::cout << (int)solver(ast) << separator;
+			std::size_t n = 0;
+			while(n < block_size && (good = (bool)(read_fp >> values[n])))
+			 ++n;
+			eval(values.data(), n, values.data());
+			for(std::size_t i = 0; i < n; ++i)
+			 std::cout << values[i] << separator;
 		}
 
 		return exit_t::success;
@@ -76,12 +112,15 @@ class MyProgram : public Program
 int main(int argc, char** argv)
 {
 	HelpStruct help;
-	help.syntax = "math/calc <equation> [newlines]";
+	help.syntax = "math/calc <equation> [newlines|bench [<count>]]";
 	help.description = eqsolver::get_help_description();
 	help.input = "sequence to be modified";
 	help.output = "modified sequence";
 	help.add_param("<equation>", "Manipulation formula in x. Double quotes suggested.");
 	help.add_param("newlines", "newlines are chosen as separators, instead of spaces");
+	help.add_param("bench", "ignore input, evaluate the equation for x = 0, 1, ... "
+		"and print the throughput in values per second");
+	help.add_param("count", "number of values for bench, default is 2^24");
 
 	MyProgram p;
 	return p.run(argc, argv, &help);
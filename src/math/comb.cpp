@@ -18,18 +18,33 @@
 /* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
 /*************************************************************************/
 
+#include <cstdlib>
 #include <cstring>
 #include "general.h"
 #include "grid.h"
-
-inline int add_ints(const int i1, const int i2) { return i1+i2; }
-inline int sub_ints(const int i1, const int i2) { return i1-i2; }
-inline int mul_ints(const int i1, const int i2) { return i1*i2; }
-inline int max_of_ints(const int i1, const int i2) { return std::max(i1, i2); }
-inline int min_of_ints(const int i1, const int i2) { return std::min(i1, i2); }
+#include "grid_algebra.h"
 
 class MyProgram : public Program
 {
+	//! returns whether @a str is an integer, stored in @a value
+	static bool is_scalar(const char* str, int& value)
+	{
+		char* end;
+		value = strtol(str, &end, 10);
+		return *str && !*end;
+	}
+
+	template<class Rhs>
+	void combine(const char* op_str, grid_t& grid, const Rhs& rhs) const
+	{
+		if(!strcmp(op_str,"add")) grid_algebra::add(grid, rhs);
+		else if(!strcmp(op_str,"sub")) grid_algebra::sub(grid, rhs);
+		else if(!strcmp(op_str,"mul")) grid_algebra::mul(grid, rhs);
+		else if(!strcmp(op_str,"max")) grid_algebra::max(grid, rhs);
+		else if(!strcmp(op_str,"min")) grid_algebra::min(grid, rhs);
+		else exitf("Unknown operator %s. Supported: add, sub, mul, max, min.\n", op_str);
+	}
+
 	exit_t main()
 	{
 		if(argc != 3)
@@ -37,33 +52,19 @@ class MyProgram : public Program
 
 		const char* op_str = argv[1];
 
-		int (*op_fptr)(const int i1, const int i2) = NULL;
-		if(!strcmp(op_str,"add")) op_fptr = &add_ints;
-		else if(!strcmp(op_str,"sub")) op_fptr = &sub_ints;
-		else if(!strcmp(op_str,"mul")) op_fptr = &mul_ints;
-		else if(!strcmp(op_str,"max")) op_fptr = &max_of_ints;
-		else if(!strcmp(op_str,"min")) op_fptr = &min_of_ints;
-		else exitf("Unknown operator %s. Supported: add, sub, mul, max, min.\n", op_str);
-
-		std::vector<int> grid1, grid2, grid0;
-		dimension dim, dim2;
-		read_grid(stdin, &grid1, &dim);
-
-		get_input(argv[2]);
-		read_grid(stdin, &grid2, &dim2);
-
-		if(dim != dim2)
-		 exit("Different dimensions in both grids are not allowed.");
+		grid_t grid1(stdin, 1);
 
-		grid0.resize(dim.area());
-		unsigned int idx;
-		for(unsigned int i=0; i<dim.area_without_border(); i++)
+		int scalar;
+		if(is_scalar(argv[2], scalar))
+		 combine(op_str, grid1, scalar);
+		else
 		{
-			idx = human2internal(i,dim.width());
-			grid0[idx] = op_fptr(grid1[idx], grid2[idx]);
+			get_input(argv[2]);
+			const grid_t grid2(stdin, 1);
+			combine(op_str, grid1, grid2);
 		}
 
-		write_grid(stdout, &grid0, &dim);
+		grid1.write(stdout);
 		return exit_t::success;
 	}
 };
@@ -72,9 +73,10 @@ int main(int argc, char** argv)
 {
 	HelpStruct help;
 	help.description = "Combines two input grids to one.";
-	help.syntax = "math/comb add|sub|min|max <shell command>";
+	help.syntax = "math/comb add|sub|mul|min|max <shell command>|<value>";
 	help.input = "first input grid";
 	help.add_param("<shell command>", "Command to generate second input grid. Double quotes suggested.");
+	help.add_param("<value>", "number to combine each cell with");
 
 	MyProgram p;
 	return p.run(argc, argv, &help);
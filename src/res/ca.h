@@ -23,11 +23,17 @@
 #ifndef CA_H
 #define CA_H
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <random>
+#include <thread>
 
 #include "random.h"
 #include "ca_basics.h"
 #include "bitgrid.h"
+#include "worker_pool.h"
 
 namespace sca { namespace ca {
 
@@ -85,6 +91,8 @@ public:
 
 	virtual const std::vector<point>& active_cells() const = 0;
 	virtual bool has_active_cells() const = 0;
+	//! appends the cells which the next round writes to @a cells
+	virtual void get_next_written(std::vector<point>& cells) const = 0;
 
 	//! returns true iff not all cells are inactive
 	virtual bool can_run() const = 0;
@@ -130,6 +138,7 @@ class _calculator_t : public Solver
 {
 	using _base = Solver;
 	using u_coord_t = typename Traits::u_coord_t;
+	using coord_t = typename Traits::coord_t;
 	using cell_t = typename CellTraits::cell_t;
 	using grid_t = _grid_t<Traits, CellTraits>;
 	using point = _point<Traits>;
@@ -207,6 +216,14 @@ public:
 		return next_state(&grid[p], p, grid.internal_dim(), res);
 	}
 
+	//! packs the neighbourhood of @a p into @a key, see
+	//!   _table_t::neighbourhood_key (only for table solvers)
+	bool neighbourhood_key(const grid_t &grid, const point& p, uint64_t& key) const
+	{
+		return _base::template neighbourhood_key<Traits, CellTraits>(
+			&grid[p], grid.internal_dim(), key);
+	}
+
 	//! overload, with x and y in internal format. slower.
 	int next_state_realxy(const cell_t *cell_ptr, const point& p, const dimension& dim) const
 	{
@@ -291,6 +308,113 @@ public:
 		return is_cell_active(grid, p, ptr);
 	}
 
+	//! bitmap type for active_map(): 1 where a cell is active, 0 otherwise
+	using active_map_t = _grid_t<Traits, cell_traits<uint8_t>>;
+
+private:
+	//! computes the activity of the rows [@a y0, @a y1) of @a area
+	void active_rows(const grid_t& grid, const _rect<Traits>& area,
+		coord_t y0, coord_t y1, active_map_t& res) const
+	{
+		const coord_t w = grid.human_dim().dx(), h = grid.human_dim().dy();
+
+		// a cell whose output neighbourhood leaves the grid is never
+		// active, so clip the columns (and rows, below) once
+		coord_t x0 = std::max(area.ul().x, (coord_t)0),
+			x1 = std::min(area.lr().x, w);
+		for(const point& np : _n_out)
+		{
+			x0 = std::max(x0, (coord_t)-np.x);
+			x1 = std::min(x1, (coord_t)(w - np.x));
+		}
+		if(x0 >= x1)
+		 return;
+		const std::size_t len = x1 - x0, n_out_size = _n_out.size();
+
+		grid_t out(_n_out.dim(), 0);
+		cell_t* const out_center = &out[cc_out];
+		// next states, one line of length len per cell of n_out
+		std::vector<cell_t> next(len * n_out_size);
+		std::vector<uint8_t> active(len);
+
+		for(coord_t y = y0; y < y1; ++y)
+		{
+			bool in_grid = true;
+			for(const point& np : _n_out)
+			 in_grid = in_grid && (y + np.y >= 0) && (y + np.y < h);
+			if(!in_grid)
+			 continue;
+
+			// pass 1: next states, written line by line
+			for(std::size_t i = 0; i < len; ++i)
+			{
+				const point p(x0 + i, y);
+				next_state(&grid[p], p, grid.internal_dim(),
+					out_center, out.internal_dim());
+				for(const auto& _np : counted(_n_out))
+				{
+					const point& np = _np;
+					next[_np.id() * len + i] = out[cc_out + np];
+				}
+			}
+
+			// pass 2: compare with the grid, all lines are contiguous
+			std::fill(active.begin(), active.end(), 0);
+			for(const auto& _np : counted(_n_out))
+			{
+				const point& np = _np;
+				const cell_t* const cur = &grid[point(x0, y) + np];
+				const cell_t* const nxt = next.data() + _np.id() * len;
+				for(std::size_t i = 0; i < len; ++i)
+				 active[i] |= (nxt[i] != cur[i]);
+			}
+			std::copy(active.begin(), active.end(), &res[point(x0, y)]);
+		}
+	}
+
+public:
+	//! computes for all cells of @a area (human coordinates) whether
+	//!   they are active, like is_cell_active(), in one sweep over the rows
+	//! @param n_threads number of threads the rows are split on,
+	//!   0 means one per core. values other than 1 require a thread safe
+	//!   solver (like table_t)
+	//! @return map of the dimension of @a grid, cells outside of @a area
+	//!   are 0
+	active_map_t active_map(const grid_t& grid, const _rect<Traits>& area,
+		unsigned n_threads = 1) const
+	{
+		active_map_t res(grid.human_dim(), grid.border_width(), 0, 0);
+		const coord_t y0 = std::max(area.ul().y, (coord_t)0),
+			y1 = std::max(y0, std::min(area.lr().y,
+				(coord_t)grid.human_dim().dy()));
+
+		if(!n_threads)
+		 n_threads = std::max(1u, std::thread::hardware_concurrency());
+		n_threads = std::max(1u, std::min(n_threads, (unsigned)(y1 - y0)));
+
+		// contiguous blocks of rows, each thread writes its own rows
+		const coord_t rows = (y1 - y0 + n_threads - 1) / n_threads;
+		std::vector<std::thread> threads;
+		for(unsigned t = 1; t < n_threads; ++t)
+		{
+			const coord_t begin = std::min(y1, (coord_t)(y0 + t * rows)),
+				end = std::min(y1, (coord_t)(begin + rows));
+			threads.emplace_back([&, begin, end]() {
+				active_rows(grid, area, begin, end, res); });
+		}
+		active_rows(grid, area, y0, std::min(y1, (coord_t)(y0 + rows)), res);
+		for(std::thread& t : threads)
+		 t.join();
+
+		return res;
+	}
+
+	//! overload for the whole grid
+	active_map_t active_map(const grid_t& grid, unsigned n_threads = 1) const
+	{
+		return active_map(grid, grid.human_dim(), n_threads);
+	}
+
 	//! complexity: at most O(log(n))
 	bool is_state_dead(const cell_t& state) const
 	{
@@ -395,20 +519,64 @@ class simulator_t : /*private _ca_calculator_t<Solver>,*/ public input_ca
 
 	using input_class = calc_class; //!< TODO: Solver class is enough
 
-	calc_class ca_calc;
-	input_class ca_input;
+	//! the CA, owned by the simulator or borrowed, see
+	//!   simulator_t(const calc_class&, bool)
+	std::unique_ptr<calc_class> own_calc;
+	const calc_class* ca_calc;
+	//! built on the first input(), if no input equation is given
+	std::unique_ptr<input_class> ca_input;
 
-	using tmp_grid_t =
-	_grid_t<typename grid_t::traits_t, cell_traits<grid_t>>;
-	tmp_grid_t tmp_grid;
+	using cell_t = typename CellTraits::cell_t;
+	using dimension = _dimension<Traits>;
 
-	grid_t _grid[3];
+	grid_t _grid[2];
 	grid_t *old_grid = _grid, *new_grid = _grid; // TODO: old grid const?
 	typename calc_class::n_t n_in, n_out, n_dep; // TODO: const?
 	std::vector<point> new_changed_cells;
-	std::vector<point> change_order; // initialize with some size?
+
+	/*
+	 * proposals: each candidate cell gets one block of cells, which
+	 * is a rectangle of dimension n_out.dim(), where next_state()
+	 * writes the proposed out neighbourhood
+	 */
+	std::vector<point> candidates; //!< sorted after collecting them
+	std::vector<cell_t> proposals; //!< one block per candidate
+	dimension block_dim; //!< n_out.dim()
+	std::size_t block_size, block_center;
+	std::vector<std::size_t> out_offsets; //!< offset of n_out[i] in a block
+
+	std::vector<std::size_t> change_order; //!< indices of changing candidates
+	std::vector<std::size_t> final_dec; //!< indices of candidates taken
+
+	//! cells reserved by taken candidates, for the current round iff
+	//!   equal to epoch; avoids clearing the board each round
+	std::vector<unsigned> reserved;
+	unsigned epoch;
+	std::mt19937 rng; //!< for the order of conflicting cells
+	/*
+	 * parallel asynchronous rounds: a calculator copy for each thread
+	 * but the first if Solver::concurrent_next_state is false, an rng
+	 * for each thread, and for each cell the highest claim of a
+	 * candidate writing to it in the current pass
+	 */
+	std::vector<calc_class> thread_calcs;
+	std::vector<std::mt19937> thread_rngs;
+	//! started on the first parallel round, reused by all later ones
+	std::unique_ptr<worker_pool_t> workers;
+	std::unique_ptr<std::atomic<uint64_t>[]> claims;
+	uint16_t claim_epoch; //!< claims of other epochs are outdated
+	enum cand_state_t : unsigned char { unchanged, taken, not_taken,
+		claiming };
+	std::vector<cand_state_t> cand_states;
+	//! random priorities, unique per round, without the epoch bits
+	std::vector<uint64_t> cand_keys;
+	std::vector<std::size_t> claimers; //!< candidates still claiming
+
+	//! hashes of grid() and of the grid of the next round,
+	//!   sums of cell_hash() over all cells, updated from changed cells
+	uint64_t hash_cur = 0, hash_next = 0;
 	//! temporary variable
-	std::set<point> cells_to_check, cells_not_token; // TODO: use pointers here, like in grid
+	std::set<point> cells_not_token; // TODO: use pointers here, like in grid
 	int round = 0; //!< steps since last input
 	bool async; // TODO: const?
 
@@ -416,17 +584,27 @@ class simulator_t : /*private _ca_calculator_t<Solver>,*/ public input_ca
 
 	void initialize_first() { run_once(); }
 
+	uint64_t cell_hash(const point& p, cell_t v) const
+	{
+		// splitmix64 finalizer
+		uint64_t z = ((uint64_t)_grid->index_h(p) << 32) ^ (uint32_t)v;
+		z += 0x9e3779b97f4a7c15ull;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
 public:
 	simulator_t(const char* equation, const char* input_equation,
 		unsigned num_states, bool async = false) :
-		ca_calc(equation, num_states),
-		ca_input(input_equation, num_states),
-		_grid{ca_calc.border_width(),
-			ca_calc.border_width(),
-			ca_calc.border_width()},
-		n_in(ca_calc.n_in()),
-		n_out(ca_calc.n_out()),
-		n_dep(ca_calc.n_dep()),
+		own_calc(new calc_class(equation, num_states)),
+		ca_calc(own_calc.get()),
+		ca_input(new input_class(input_equation, num_states)),
+		_grid{ca_calc->border_width(),
+			ca_calc->border_width()},
+		n_in(ca_calc->n_in()),
+		n_out(ca_calc->n_out()),
+		n_dep(ca_calc->n_dep()),
 		async(async)
 	{
 	}
@@ -445,13 +623,29 @@ public:
 
 	simulator_t(std::istream& stream, const char* input_equation = def_in_eq,
 		bool async = false) :
-		ca_calc(stream),
-		ca_input(input_equation, 0),
-		_grid{ca_calc.border_width(),
-			ca_calc.border_width(),
-			ca_calc.border_width()},
-		n_in(ca_calc.n_in()),
-		n_out(ca_calc.n_out()),
+		own_calc(new calc_class(stream)),
+		ca_calc(own_calc.get()),
+		ca_input(new input_class(input_equation, ca_calc->num_states())),
+		_grid{ca_calc->border_width(),
+			ca_calc->border_width()},
+		n_in(ca_calc->n_in()),
+		n_out(ca_calc->n_out()),
+		n_dep(ca_calc->n_dep()),
+		async(async)
+	{
+	}
+
+	//! uses the CA of @a calc without copying it, e.g. to run many
+	//!   simulators of one table. @a calc must outlive the simulator.
+	//!   simulators in different threads may only share @a calc if
+	//!   Solver::concurrent_next_state is true
+	simulator_t(const calc_class& calc, bool async = false) :
+		ca_calc(&calc),
+		_grid{ca_calc->border_width(),
+			ca_calc->border_width()},
+		n_in(ca_calc->n_in()),
+		n_out(ca_calc->n_out()),
+		n_dep(ca_calc->n_dep()),
 		async(async)
 	{
 	}
@@ -463,11 +657,13 @@ public:
 	// TODO: there is no virtual function right now...
 	void reset_ca(const char* equation, const char* input_equation)
 	{
-		ca_calc = calc_class(equation);
-		ca_input = input_class(input_equation);
-		grid().resize_borders(ca_calc.border_width());
-		n_in = ca_calc.n_in();
-		n_out = ca_calc.n_out();
+		own_calc.reset(new calc_class(equation));
+		ca_calc = own_calc.get();
+		thread_calcs.clear();
+		ca_input.reset(new input_class(input_equation));
+		grid().resize_borders(ca_calc->border_width());
+		n_in = ca_calc->n_in();
+		n_out = ca_calc->n_out();
 	}
 
 	// TODO: no function should take grid pointer
@@ -505,25 +701,55 @@ public:
 	//! prepares the ca to run only on cells from @a sim_rect
 	void finalize(const _rect<Traits>& sim_rect)
 	{
-		// incorrect if we finalize later? (what is 0 and 1?)
-		_grid[1] = _grid[0]; // fit borders
-		_grid[2] = _grid[0], _grid[2].reset(0);
+		// seeded from sca_random, so sca_random::set_seed()
+		// makes runs reproducible
+		finalize(sim_rect, random());
+	}
 
-		grid_t fill(n_out.dim(), 0);
-		tmp_grid = tmp_grid_t(_grid[0].human_dim(), ca_calc.border_width(), fill, fill);
-		for(const point& p : tmp_grid.points()) // TODO: common routine
+	//! like finalize(const rect&), but seeds the simulator's own rng
+	//!   with @a seed, so no global state is used
+	//! can be called again after setting a new grid()
+	void finalize(const _rect<Traits>& sim_rect, unsigned seed)
+	{
+		// grid() may be either grid after previous runs
+		if(old_grid != _grid)
+		 _grid[0] = *old_grid;
+		old_grid = new_grid = _grid;
+		round = 0;
+		new_changed_cells.clear();
+		cells_not_token.clear();
+
+		_grid[1] = _grid[0]; // fit borders
+		reserved.assign(_grid[0].internal_dim().area(), 0);
+		epoch = 0;
+		rng.seed(seed);
+		thread_calcs.clear();
+		thread_rngs.clear();
+		claims.reset();
+		claim_epoch = 0;
+
+		hash_next = 0;
+		for(const point& p : _rect<Traits>(_grid->human_dim()))
+		 hash_next += cell_hash(p, _grid[0][p]);
+
+		block_dim = n_out.size() ? n_out.dim() : dimension(1, 1);
+		block_size = block_dim.area();
+		const point bc = n_out.size() ? n_out.center() : point(0, 0);
+		block_center = bc.y * block_dim.dx() + bc.x;
+		out_offsets.clear();
 		for(const point& np : n_out)
-		 tmp_grid[p + np];
+		 out_offsets.push_back(block_center + np.y * block_dim.dx() + np.x);
 
 		// make all cells active, but not those close to the border
 		// TODO: make this generic for arbitrary neighbourhoods
 	//	new_changed_cells.reserve(sim_rect.area());
+		const auto active = ca_calc->active_map(_grid[0], sim_rect);
 		for( const point &p : sim_rect ) {
 			// TODO: use active criterion if possible
 			// TODO: otherwise, invariant can be broken...
 			// TODO: (because these cells are not active)
 			//for(const point np : n_in)
-			if(ca_calc.is_cell_active(_grid[0], p))
+			if(active[p])
 			 new_changed_cells.push_back(p);
 		}
 
@@ -535,146 +761,152 @@ public:
 
 	// TODO: function run_once_async()
 
-	//! runs the ca once, but only ever activating cells from @a sim_rect
-	template<class Asynchronicity>
-	void _run_once(const rect& sim_rect,
-		const Asynchronicity& async = synchronous())
+	//! starts a round: switches the grids and collects the candidates
+	//!   from @a sim_rect
+	void begin_round(const rect& sim_rect)
 	{
 		// switch grids
 		old_grid = _grid + ((round+1)&1);
 		new_grid = _grid + ((round)&1);
+		hash_cur = hash_next;
 
-		cells_to_check.clear();
-
-		// adds the cell to cells_to_check if it is variable
-		const auto add_cell_if_variable_and_async = [&](const point& p)
-		{
-			if(sim_rect.is_inside(p))
-			{
-				/*(*new_grid)[p] =*/
-
-				grid_t& cur_res_grid = tmp_grid[p];
-#if 0
-				ca_calc.next_state
-					(&((*old_grid)[p]),
-						p, _grid->internal_dim(),
-						&((*new_grid)[p]), _grid->internal_dim());
-#else
-				ca_calc.next_state
-					(&((*old_grid)[p]),
-						p, _grid->internal_dim(),
-						&cur_res_grid[n_out.center()], n_out.dim());
-#endif
-
-				bool changes = false;
-				for(auto itr = n_out.cbegin(); !changes && (itr != n_out.cend()); ++itr)
-				{
-					point ip = *itr + p;
-
-					// note: async(2) means that active cells can be activated or not
-					changes = changes || ( sim_rect.is_inside(ip) &&
-						(cur_res_grid[*itr] != (*old_grid)[ip]) && async(2));
-					/*if(changes)
-					{
-						std::cerr << "neq:" << ip << std::endl;
-						std::cerr << cur_res_grid[*itr] << " <-> " << (*old_grid)[ip] << std::endl;
-					}*/
-				}
-				if(changes)
-				{
-					//std::cerr << "FOUND ACTIVE CELL: " << p << std::endl;
-					cells_to_check.insert(p);
-				}
-			}
-		};
+		// new_grid still holds the grid of two rounds ago, so take over
+		// the cells which changed in the last round
+		for(const point& ap : new_changed_cells)
+		n_out.for_each(ap, [&](const point& p){
+			(*new_grid)[p] = (*old_grid)[p];
+		});
 
-//		new_grid->reset(std::numeric_limits<int>::min());
-		
 		// variable cells this round are either neighbours of
 		// recently changed cells...
+		candidates.clear();
 		for(const point& ap : new_changed_cells)
 		for(const point& np : n_dep)
-		 add_cell_if_variable_and_async(ap + np);
+		{
+			const point p = ap + np;
+			if(sim_rect.is_inside(p))
+			 candidates.push_back(p);
+		}
 		new_changed_cells.resize(0); // will not affect capacity!
 
-		// ... or neighbours of cells that 
+		// ... or cells that could not be token last round
 		for(const point& p : cells_not_token)
-		 add_cell_if_variable_and_async(p);
+		if(sim_rect.is_inside(p))
+		 candidates.push_back(p);
 		cells_not_token.clear();
 
-	//	std::cerr << "NG:" << std::endl << (*new_grid) << std::endl;
-		
-		// shuffle the order of active cells
-		std::copy(cells_to_check.begin(), cells_to_check.end(), std::back_inserter(change_order));
-
-		std::random_device rd;
-		std::mt19937 g(rd());
-		std::shuffle(change_order.begin(), change_order.end(), g);
-
-		_grid[2].reset(0); // TODO: reset all?
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()),
+			candidates.end());
+	}
 
-		std::set<point> final_dec;
+	//! ends a round: writes the proposals of the candidates in
+	//!   final_dec and keeps the cells in cells_not_token
+	void end_round()
+	{
+		for(const point& p : cells_not_token)
+		 (*new_grid)[p] = (*old_grid)[p];
 
-		// find out which cells can be token
-		// (=> final dec, reserved on _grid[2])
-		// and which can not (=> cells not token)
-		// TODO: the log factor would be avoidable...
-		for(point& cp : change_order)
+		// candidate indices are sorted like the points
+		std::sort(final_dec.begin(), final_dec.end());
+		for(const std::size_t i : final_dec)
 		{
-			const auto point_avail = [&](const point& p){
-			//	std::cerr << p << ": " << _grid[2][p] << std::endl;
-				return !_grid[2][p]; };
-			if(n_out.for_each_bool(cp, point_avail)) {
-				const auto reserve_point = [&](const point& p){ _grid[2][p] = 1; };
-				n_out.for_each(cp, reserve_point);
-				final_dec.insert(cp);
-			}
-			else {
-				//std::cerr << "rejected: "<< cp <<std::endl;
-				cells_not_token.insert(cp);
-				cp = point(-1, -1);
+			const point& p = candidates[i];
+			const cell_t* const block = proposals.data() + i * block_size;
+			for(std::size_t o = 0; o < out_offsets.size(); ++o)
+			{
+				const point ip = p + n_out[o];
+				cell_t& c = (*new_grid)[ip];
+				hash_next += cell_hash(ip, block[out_offsets[o]])
+					- cell_hash(ip, c);
+				c = block[out_offsets[o]];
 			}
+			new_changed_cells.push_back(p);
 		}
-		change_order.resize(0);
 
-	//	std::cerr << "reserved:" << _grid[2] << std::endl;
+		++round;
+	}
 
-		/*for(const point& p : sim_rect)
-		if(final_dec.find(p) == final_dec.end())
-		 (*new_grid)[p] = (*old_grid)[p];
-		else*/
-		for(const point& p : cells_not_token)
+	//! runs the ca once, but only ever activating cells from @a sim_rect
+	template<class Asynchronicity>
+	void _run_once(const rect& sim_rect,
+		const Asynchronicity& async = synchronous())
+	{
+		begin_round(sim_rect);
+
+		// compute the proposals of all candidates, and keep the
+		// candidates whose proposals change cells
+		proposals.resize(candidates.size() * block_size);
+		for(std::size_t i = 0; i < candidates.size(); ++i)
 		{
-			// TODO: duplicate of above call!
-		/*	ca_calc.next_state
-					(&((*old_grid)[p]),
-						p, _grid->internal_dim(),
-						&((*new_grid)[p]), _grid->internal_dim());*/
-			(*new_grid)[p] = (*old_grid)[p];
-			/*n_out.for_each(n_out.center(), [&](const point& np){
-				(*new_grid)[p + np] = (*old_grid)[p + np];
-			});*/
+			const point& p = candidates[i];
+			cell_t* const block = proposals.data() + i * block_size;
+			ca_calc->next_state
+				(&((*old_grid)[p]),
+					p, _grid->internal_dim(),
+					block + block_center, block_dim);
+
+			bool changes = false;
+			for(std::size_t o = 0; !changes && o < out_offsets.size(); ++o)
+			{
+				const point ip = n_out[o] + p;
+
+				// note: async(2) means that active cells can be activated or not
+				changes = sim_rect.is_inside(ip) &&
+					(block[out_offsets[o]] != (*old_grid)[ip]) && async(2);
+			}
+			if(changes)
+			 change_order.push_back(i);
 		}
 
-		for(const point& p : final_dec)
+		// find out which cells can be token
+		// (=> final dec, reserved in this round's epoch)
+		// and which can not (=> cells not token)
+		// cells writing to the border can never be token
+		const auto in_grid = [&](const point& p){
+			return _grid->contains(p); };
+		final_dec.clear();
+		if(n_out.size() <= 1)
 		{
-			// TODO: duplicate of above call!
-		/*	ca_calc.next_state
-					(&((*old_grid)[p]),
-						p, _grid->internal_dim(),
-						&((*new_grid)[p]), _grid->internal_dim());*/
-			n_out.for_each(n_out.center(), [&](const point& np){
-				(*new_grid)[p + np] = tmp_grid[p][np];
-			});
+			// out neighbourhoods of different cells can not overlap
+			for(const std::size_t i : change_order)
+			if(n_out.for_each_bool(candidates[i], in_grid))
+			 final_dec.push_back(i);
+			else
+			 cells_not_token.insert(candidates[i]);
 		}
+		else
+		{
+			// shuffle the order of active cells
+			std::shuffle(change_order.begin(), change_order.end(), rng);
 
-		std::move(final_dec.begin(), final_dec.end(), std::back_inserter(new_changed_cells));
+			if(!++epoch) // overflow => old stamps would be valid again
+			{
+				std::fill(reserved.begin(), reserved.end(), 0);
+				epoch = 1;
+			}
+			const auto point_avail = [&](const point& p){
+				return in_grid(p) && reserved[_grid->index_h(p)] != epoch; };
+			const auto reserve_point = [&](const point& p){
+				reserved[_grid->index_h(p)] = epoch; };
+			for(const std::size_t i : change_order)
+			{
+				const point& cp = candidates[i];
+				if(n_out.for_each_bool(cp, point_avail)) {
+					n_out.for_each(cp, reserve_point);
+					final_dec.push_back(i);
+				}
+				else
+				 cells_not_token.insert(cp);
+			}
+		}
+		change_order.resize(0);
 
 	//	std::cerr << "NOW:" <<  std::endl;
 	//	std::cerr << *old_grid;
 	//	std::cerr << *new_grid;
 
-		++round;
+		end_round();
 	}
 
 	// TODO: move up to virtual class
@@ -683,6 +915,21 @@ public:
 	const std::vector<point>& active_cells() const { return new_changed_cells; }
 	bool has_active_cells() const { return !active_cells().empty(); }
 
+	//! calls @a ftor for all cells which the next round writes,
+	//!   i.e. for the out neighbourhoods of the active cells
+	template<class Functor>
+	void for_each_next_written(const Functor& ftor) const
+	{
+		for(const point& ap : new_changed_cells)
+		 n_out.for_each(ap, ftor);
+	}
+
+	void get_next_written(std::vector<point>& cells) const
+	{
+		for_each_next_written([&](const point& p) {
+			cells.push_back(p); });
+	}
+
 	//! runs the whole ca
 	template<class Asynchronicity>
 	void _run_once(const Asynchronicity& async = synchronous())
@@ -700,6 +947,229 @@ public:
 	}
 
 
+	//! asynchronicity from the simulator's own rng, which can be seeded
+	//!   by finalize(const rect&, unsigned)
+	struct own_asynchronicity {};
+
+	//! runs the whole ca
+	void run_once(const own_asynchronicity& )
+	{
+		std::mt19937& r = rng;
+		_run_once(_grid->human_dim(),
+			[&r](unsigned n) -> bool { return r() % n; });
+	}
+
+	//! asynchronicity like default_asynchronicity, but computed by
+	//!   multiple threads with their own rngs, seeded by finalize()
+	struct parallel_asynchronicity
+	{
+		unsigned n_threads; //!< 0 means one per core
+		//! resolve conflicts serially, by reserving the out cells in
+		//!   the order of descending priorities; meant for testing
+		bool serial_order;
+		explicit parallel_asynchronicity(unsigned n_threads = 0,
+			bool serial_order = false) :
+			n_threads(n_threads), serial_order(serial_order) {}
+	};
+
+private:
+	//! calls @a ftor(thread, begin, end) for @a n_threads contiguous
+	//!   chunks of [0, @a n) in parallel, on the simulator's workers
+	template<class Functor>
+	void for_each_chunk(unsigned n_threads, std::size_t n,
+		const Functor& ftor)
+	{
+		const std::size_t chunk = (n + n_threads - 1) / n_threads;
+		if(!workers)
+		 workers.reset(new worker_pool_t());
+		workers->run(n_threads, [&](unsigned t) {
+			ftor(t, std::min(n, t * chunk), std::min(n, (t + 1) * chunk));
+		});
+	}
+
+public:
+	/**
+	 * Runs the whole ca asynchronously on multiple threads. Like for
+	 * default_asynchronicity, each cell is activated with probability
+	 * 1/2. Conflicts of out neighbourhoods are resolved without locks:
+	 * each activated cell gets a random priority and claims its out
+	 * cells in passes. After each pass, the cells holding all their
+	 * claims are taken, and the cells conflicting with them are
+	 * activated again in the next round. The others claim again. The
+	 * taken cells are the same as if the serial pass reserved the out
+	 * cells in the order of descending priorities.
+	 */
+	void run_once(const parallel_asynchronicity& par)
+	{
+		const rect sim_rect = _grid->human_dim();
+		begin_round(sim_rect);
+
+		const std::size_t n = candidates.size();
+		unsigned n_threads = par.n_threads ? par.n_threads
+			: std::thread::hardware_concurrency();
+		n_threads = std::max(1u,
+			(unsigned)std::min<std::size_t>(n_threads, n));
+		if(!Solver::concurrent_next_state)
+		while(thread_calcs.size() + 1 < n_threads)
+		 thread_calcs.push_back(*ca_calc);
+		while(thread_rngs.size() < n_threads)
+		 thread_rngs.emplace_back(rng());
+
+		const bool conflicts = n_out.size() > 1;
+		const std::size_t area = _grid->internal_dim().area();
+		if(conflicts && !claims)
+		 claims.reset(new std::atomic<uint64_t>[area]());
+
+		proposals.resize(n * block_size);
+		cand_states.assign(n, unchanged);
+		cand_keys.resize(n);
+		const auto in_grid = [&](const point& p){
+			return _grid->contains(p); };
+
+		// compute proposals and priorities
+		for_each_chunk(n_threads, n, [&](unsigned t, std::size_t begin,
+			std::size_t end) {
+			const calc_class& calc = (t && !Solver::concurrent_next_state)
+				? thread_calcs[t - 1] : *ca_calc;
+			std::mt19937& r = thread_rngs[t];
+			for(std::size_t i = begin; i < end; ++i)
+			{
+				const point& p = candidates[i];
+				cell_t* const block = proposals.data() + i * block_size;
+				calc.next_state(&((*old_grid)[p]), p,
+					_grid->internal_dim(), block + block_center, block_dim);
+
+				bool changes = false;
+				for(std::size_t o = 0; !changes && o < out_offsets.size(); ++o)
+				{
+					const point ip = n_out[o] + p;
+					changes = sim_rect.is_inside(ip) &&
+						(block[out_offsets[o]] != (*old_grid)[ip]) && r() % 2;
+				}
+
+				if(!changes)
+				 continue;
+				else if(!n_out.for_each_bool(p, in_grid))
+				 cand_states[i] = not_taken;
+				else if(!conflicts)
+				 cand_states[i] = taken;
+				else
+				{
+					// the index makes the key unique
+					cand_keys[i] = ((uint64_t)(r() & 0xffff) << 32) | (i + 1);
+					cand_states[i] = claiming;
+				}
+			}
+		});
+
+		claimers.clear();
+		for(std::size_t i = 0; i < n; ++i)
+		if(cand_states[i] == claiming)
+		 claimers.push_back(i);
+		if(!claimers.empty() && !++epoch) // see _run_once()
+		{
+			std::fill(reserved.begin(), reserved.end(), 0);
+			epoch = 1;
+		}
+
+		if(par.serial_order)
+		{
+			std::sort(claimers.begin(), claimers.end(),
+				[&](std::size_t i, std::size_t j) {
+					return cand_keys[i] > cand_keys[j]; });
+			const auto point_avail = [&](const point& p){
+				return reserved[_grid->index_h(p)] != epoch; };
+			for(const std::size_t i : claimers)
+			if(n_out.for_each_bool(candidates[i], point_avail))
+			{
+				n_out.for_each(candidates[i], [&](const point& p) {
+					reserved[_grid->index_h(p)] = epoch; });
+				cand_states[i] = taken;
+			}
+			else
+			 cand_states[i] = not_taken;
+			claimers.clear();
+		}
+
+		// each pass takes at least the claimer with the highest key
+		while(!claimers.empty())
+		{
+			// a new epoch makes the claims of the last pass outdated
+			if(!++claim_epoch)
+			{
+				for(std::size_t i = 0; i < area; ++i)
+				 claims[i].store(0, std::memory_order_relaxed);
+				claim_epoch = 1;
+			}
+			const uint64_t epoch_bits = (uint64_t)claim_epoch << 48;
+			const std::size_t n_claimers = claimers.size();
+			const unsigned n_claim_threads = std::max(1u,
+				(unsigned)std::min<std::size_t>(n_threads, n_claimers));
+
+			for_each_chunk(n_claim_threads, n_claimers, [&](unsigned ,
+				std::size_t begin, std::size_t end) {
+				for(std::size_t k = begin; k < end; ++k)
+				{
+					const uint64_t key = epoch_bits | cand_keys[claimers[k]];
+					n_out.for_each(candidates[claimers[k]],
+						[&](const point& ip) {
+						std::atomic<uint64_t>& c = claims[_grid->index_h(ip)];
+						uint64_t cur = c.load(std::memory_order_relaxed);
+						while(cur < key && !c.compare_exchange_weak(cur, key,
+							std::memory_order_relaxed)) ;
+					});
+				}
+			});
+
+			// the pool waited for all workers, so all claims are visible.
+			// the out cells of the taken cells are disjoint
+			for_each_chunk(n_claim_threads, n_claimers, [&](unsigned ,
+				std::size_t begin, std::size_t end) {
+				for(std::size_t k = begin; k < end; ++k)
+				{
+					const std::size_t i = claimers[k];
+					const uint64_t key = epoch_bits | cand_keys[i];
+					if(n_out.for_each_bool(candidates[i],
+						[&](const point& ip) {
+							return claims[_grid->index_h(ip)].load(
+								std::memory_order_relaxed) == key; }))
+					{
+						cand_states[i] = taken;
+						n_out.for_each(candidates[i], [&](const point& ip) {
+							reserved[_grid->index_h(ip)] = epoch; });
+					}
+				}
+			});
+
+			// claimers conflicting with taken cells are not taken
+			for_each_chunk(n_claim_threads, n_claimers, [&](unsigned ,
+				std::size_t begin, std::size_t end) {
+				for(std::size_t k = begin; k < end; ++k)
+				{
+					const std::size_t i = claimers[k];
+					if(cand_states[i] == claiming &&
+						!n_out.for_each_bool(candidates[i],
+						[&](const point& ip) {
+							return reserved[_grid->index_h(ip)] != epoch; }))
+					 cand_states[i] = not_taken;
+				}
+			});
+
+			claimers.erase(std::remove_if(claimers.begin(), claimers.end(),
+				[&](std::size_t i) { return cand_states[i] != claiming; }),
+				claimers.end());
+		}
+
+		final_dec.clear();
+		for(std::size_t i = 0; i < n; ++i)
+		if(cand_states[i] == taken)
+		 final_dec.push_back(i);
+		else if(cand_states[i] == not_taken)
+		 cells_not_token.insert(candidates[i]);
+
+		end_round();
+	}
+
 	//! runs the whole ca
 	//template<class Asynchronicity>
 	virtual void run_once() { _run_once(synchronous()); }
@@ -711,6 +1181,17 @@ public:
 	}
 
 
+	//! hash of grid(), updated in O(changed cells) per round
+	//! @note only valid if grid() is not changed after finalize()
+	uint64_t board_hash() const { return hash_cur; }
+
+	//! whether synchronous rounds only depend on the grid, i.e. no
+	//!   random conflict resolution is needed
+	bool deterministic() const { return n_out.size() <= 1; }
+
+	//! the CA, e.g. to choose a specialised simulator for it
+	const calc_class& calculator() const { return *ca_calc; }
+
 	//! returns true iff not all cells are inactive
 	bool can_run() const {
 		return (new_changed_cells.size() || async); // TODO: async condition is wrong
@@ -738,13 +1219,16 @@ public:
 	{
 		//if(has_)
 		// TODO: for now, we assume that the ca is always stable
-		(*old_grid)[p] = (*new_grid)[p] =
-			ca_input.next_state_old(*new_grid, p);
+		if(!ca_input)
+		 ca_input.reset(new input_class(def_in_eq, ca_calc->num_states()));
+		const cell_t v = ca_input->next_state_old(*new_grid, p);
+		hash_next += cell_hash(p, v) - cell_hash(p, (*new_grid)[p]);
+		(*old_grid)[p] = (*new_grid)[p] = v;
 		/*for(const point np : n_in)
 		{
 			point cur = p + np;
 			if(!grid().point_is_on_border(cur)
-				&& ca_calc.is_cell_active(*new_grid, cur))
+				&& ca_calc->is_cell_active(*new_grid, cur))
 			 new_changed_cells.push_back(cur);
 		}*/
 		new_changed_cells.push_back(p);
@@ -753,7 +1237,7 @@ public:
 	}
 
 	typename Traits::u_coord_t border_width() const {
-		return ca_calc.border_width();
+		return ca_calc->border_width();
 	}
 };
 
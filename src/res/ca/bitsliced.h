@@ -0,0 +1,351 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+//! @file bitsliced.h synchronous simulation of 2 state, outer
+//!   totalistic CAs on the Moore neighbourhood, 64 cells per word
+
+#ifndef BITSLICED_H
+#define BITSLICED_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "ca.h"
+#include "grid.h"
+
+namespace sca { namespace ca {
+
+/**
+ * @brief Bit-sliced simulator for CAs like game of life.
+ *
+ * Each row of the grid is stored as a bit vector. Each round, the
+ * number of live neighbours of 64 cells is computed at once with
+ * bitwise adders, and the rule, given as birth and survival counts,
+ * is applied bitwise.
+ *
+ * The rule is derived from the calculator by evaluating it on all
+ * 3x3 neighbourhoods of 0 and 1. It must be outer totalistic, i.e.
+ * only depend on the cell and the number of its live neighbours, and
+ * it may not read the coordinates, see Solver::uses_position().
+ * Cells on the rim of the grid read border cells; for them, the
+ * calculator is evaluated once per rim shape and neighbourhood, and
+ * then looked up, so the results are the same as for simulator_t.
+ */
+template<class Solver, class Traits, class CellTraits>
+class bitsliced_t
+{
+	using calculator_t = _calculator_t<Solver, Traits, CellTraits>;
+	using cell_t = typename CellTraits::cell_t;
+	using coord_t = typename Traits::coord_t;
+	using point = _point<Traits>;
+	using dimension = _dimension<Traits>;
+	using grid_t = _grid_t<Traits, CellTraits>;
+
+	//! rim shapes: which sides of a cell are outside the grid
+	enum { north = 1, south = 2, west = 4, east = 8 };
+
+	//! next states, indexed by shape and by the 3x3 neighbourhood,
+	//!   bit (dy+1)*3+(dx+1) for the cell at offset (dx, dy)
+	using rule_tables_t = std::array<std::array<uint8_t, 512>, 16>;
+
+	struct rule_t
+	{
+		uint16_t birth = 0, survive = 0; //!< bit n: for n live neighbours
+		rule_tables_t tables;
+		//! whether cells on the rim differ from interior cells next
+		//!   to cells of state 0, i.e. whether the border matters
+		bool rim = false;
+	};
+
+	rule_t rule;
+	coord_t w, h;
+	std::size_t words; //!< per row
+	uint64_t last_mask; //!< valid bits of the last word of a row
+	std::vector<uint64_t> cur, next, zero;
+
+	//! neighbour counts for which cells can be alive after a round,
+	//!   with masks for whether dead cells are born and live ones survive
+	unsigned counts[9], num_counts = 0;
+	uint64_t born[9], survives[9];
+
+	//! evaluates @a calc for all neighbourhoods, returns false iff
+	//!   the CA is not supported
+	static bool derive(const calculator_t& calc, rule_t& rule)
+	{
+		if(calc.uses_position())
+		 return false;
+		const bool writes_center = calc.n_out().size() != 0;
+		if(calc.n_out().size() > 1 || (writes_center
+			&& calc.n_out()[0] != point(0, 0)))
+		 return false;
+		for(const point& p : calc.n_in())
+		if(p.x < -1 || p.x > 1 || p.y < -1 || p.y > 1)
+		 return false;
+
+		const cell_t border = std::numeric_limits<cell_t>::min();
+		int totalistic[2][9];
+		for(int c = 0; c < 2; ++c)
+		for(int n = 0; n < 9; ++n)
+		 totalistic[c][n] = -1;
+
+		for(unsigned shape = 0; shape < 16; ++shape)
+		if((shape & (north|south)) != (north|south)
+			&& (shape & (west|east)) != (west|east))
+		for(unsigned cfg = 0; cfg < 512; ++cfg)
+		{
+			cell_t buf[9];
+			unsigned outside_bits = 0;
+			for(int i = 0; i < 9; ++i)
+			{
+				const int dx = i % 3 - 1, dy = i / 3 - 1;
+				const bool outside = (dy < 0 && (shape & north))
+					|| (dy > 0 && (shape & south))
+					|| (dx < 0 && (shape & west))
+					|| (dx > 0 && (shape & east));
+				buf[i] = outside ? border : (cell_t)((cfg >> i) & 1);
+				outside_bits |= (unsigned)outside << i;
+			}
+
+			cell_t out = buf[4];
+			if(writes_center)
+			 calc.next_state(buf + 4, point(0, 0), dimension(3, 3),
+				&out, dimension(1, 1));
+			if(out != 0 && out != 1)
+			 return false;
+			rule.tables[shape][cfg] = out;
+			if(!(cfg & outside_bits) && out != rule.tables[0][cfg])
+			 rule.rim = true;
+
+			if(!shape)
+			{
+				const int c = (cfg >> 4) & 1;
+				const int n = __builtin_popcount(cfg & ~(1u << 4));
+				if(totalistic[c][n] >= 0 && totalistic[c][n] != out)
+				 return false;
+				totalistic[c][n] = out;
+			}
+		}
+
+		for(int n = 0; n < 9; ++n)
+		{
+			rule.birth |= (uint16_t)totalistic[0][n] << n;
+			rule.survive |= (uint16_t)totalistic[1][n] << n;
+		}
+		return true;
+	}
+
+	bool bit(coord_t x, coord_t y) const
+	{
+		return x >= 0 && y >= 0 && x < w && y < h
+			&& ((cur[y * words + (x >> 6)] >> (x & 63)) & 1);
+	}
+
+	void set_bit(std::vector<uint64_t>& v, coord_t x, coord_t y, bool b)
+	{
+		uint64_t& word = v[y * words + (x >> 6)];
+		const uint64_t m = (uint64_t)1 << (x & 63);
+		word = b ? (word | m) : (word & ~m);
+	}
+
+	//! computes the rim cell (@a x, @a y) from the rule tables
+	void rim_cell(coord_t x, coord_t y)
+	{
+		const unsigned shape = (y == 0 ? north : 0)
+			| (y == h - 1 ? south : 0)
+			| (x == 0 ? west : 0)
+			| (x == w - 1 ? east : 0);
+		unsigned cfg = 0;
+		for(int i = 0; i < 9; ++i)
+		 cfg |= (unsigned)bit(x + i % 3 - 1, y + i / 3 - 1) << i;
+		set_bit(next, x, y, rule.tables[shape][cfg]);
+	}
+
+	//! recomputes all cells on the rim from the rule tables
+	void rim()
+	{
+		for(coord_t x = 0; x < w; ++x)
+		{
+			rim_cell(x, 0);
+			rim_cell(x, h - 1);
+		}
+		for(coord_t y = 1; y < h - 1; ++y)
+		{
+			rim_cell(0, y);
+			rim_cell(w - 1, y);
+		}
+	}
+
+	//! number of set bits west of, at (iff @a with_mid) and east of
+	//!   each bit of word @a k of row @a rw, as 2 bit number hi lo
+	static void sum_row(const uint64_t* rw, std::size_t k,
+		std::size_t words, bool with_mid, uint64_t& lo, uint64_t& hi)
+	{
+		const uint64_t mid = rw[k];
+		const uint64_t wst = (mid << 1) | (k ? rw[k - 1] >> 63 : 0);
+		const uint64_t est = (mid >> 1)
+			| (k + 1 < words ? rw[k + 1] << 63 : 0);
+		if(with_mid)
+		{
+			lo = wst ^ mid ^ est;
+			hi = (wst & mid) | (est & (wst ^ mid));
+		}
+		else
+		{
+			lo = wst ^ est;
+			hi = wst & est;
+		}
+	}
+
+	//! one row, rows outside the grid are 0
+	void row(coord_t y)
+	{
+		const uint64_t* const above = y > 0 ? &cur[(y - 1) * words]
+			: zero.data();
+		const uint64_t* const here = &cur[y * words];
+		const uint64_t* const below = y < h - 1 ? &cur[(y + 1) * words]
+			: zero.data();
+		uint64_t* const out = &next[y * words];
+
+		// local copies, since writing to out might alias the members
+		const std::size_t words = this->words;
+		const unsigned num_counts = this->num_counts;
+		uint64_t count_bits[9][4], born[9], survives[9];
+		for(unsigned i = 0; i < num_counts; ++i)
+		{
+			for(unsigned j = 0; j < 4; ++j)
+			 count_bits[i][j] = ((counts[i] >> j) & 1) ? ~(uint64_t)0 : 0;
+			born[i] = this->born[i];
+			survives[i] = this->survives[i];
+		}
+
+		for(std::size_t k = 0; k < words; ++k)
+		{
+			uint64_t a0, a1, b0, b1, c0, c1;
+			sum_row(above, k, words, true, a0, a1);
+			sum_row(here, k, words, false, b0, b1);
+			sum_row(below, k, words, true, c0, c1);
+
+			// add the three 2 bit numbers to the neighbour count s3..s0
+			const uint64_t s0 = a0 ^ b0 ^ c0;
+			const uint64_t carry = (a0 & b0) | (c0 & (a0 ^ b0));
+			const uint64_t x = a1 ^ b1 ^ c1;
+			const uint64_t m = (a1 & b1) | (c1 & (a1 ^ b1));
+			const uint64_t s1 = x ^ carry;
+			const uint64_t d = x & carry;
+			const uint64_t s2 = m ^ d;
+			const uint64_t s3 = m & d;
+
+			const uint64_t center = here[k];
+			uint64_t res = 0;
+			for(unsigned i = 0; i < num_counts; ++i)
+			{
+				// bits where the count equals counts[i]
+				const uint64_t* const n = count_bits[i];
+				const uint64_t eq = ~((s0 ^ n[0]) | (s1 ^ n[1])
+					| (s2 ^ n[2]) | (s3 ^ n[3]));
+				res |= eq & ((born[i] & ~center) | (survives[i] & center));
+			}
+			out[k] = res;
+		}
+		out[words - 1] &= last_mask;
+	}
+
+public:
+	//! whether @a calc can be simulated bit-sliced
+	static bool supports(const calculator_t& calc)
+	{
+		rule_t r;
+		return derive(calc, r);
+	}
+
+	//! whether @a g only contains states 0 and 1 and is big enough
+	static bool supports(const grid_t& g)
+	{
+		if(g.human_dim().dx() < 2 || g.human_dim().dy() < 2)
+		 return false;
+		for(const point& p : g.points())
+		if(g[p] != 0 && g[p] != 1)
+		 return false;
+		return true;
+	}
+
+	bitsliced_t(const calculator_t& calc, const grid_t& g) :
+		w(g.human_dim().dx()),
+		h(g.human_dim().dy()),
+		words((w + 63) >> 6),
+		last_mask((w & 63) ? (((uint64_t)1 << (w & 63)) - 1) : ~(uint64_t)0),
+		cur(words * h, 0),
+		next(words * h, 0),
+		zero(words, 0)
+	{
+		if(!derive(calc, rule))
+		 throw "Bit-sliced simulation only supports 2 state, outer "
+			"totalistic CAs on the Moore neighbourhood.";
+		if(!supports(g))
+		 throw "Bit-sliced simulation needs grids of 0 and 1.";
+		for(unsigned n = 0; n < 9; ++n)
+		if(((rule.birth | rule.survive) >> n) & 1)
+		{
+			counts[num_counts] = n;
+			born[num_counts] = ((rule.birth >> n) & 1) ? ~(uint64_t)0 : 0;
+			survives[num_counts++] = ((rule.survive >> n) & 1)
+				? ~(uint64_t)0 : 0;
+		}
+		for(const point& p : g.points())
+		 set_bit(cur, p.x, p.y, g[p]);
+	}
+
+	//! runs one round
+	//! @return whether any cell changed
+	bool run_once()
+	{
+		for(coord_t y = 0; y < h; ++y)
+		 row(y);
+		if(rule.rim)
+		 rim();
+		cur.swap(next);
+		return cur != next;
+	}
+
+	//! hash of the current grid
+	uint64_t hash() const
+	{
+		uint64_t res = 0xcbf29ce484222325ull;
+		for(const uint64_t word : cur)
+		 res = (res ^ word) * 0x100000001b3ull ^ (res >> 29);
+		return res;
+	}
+
+	//! number of cells
+	std::size_t area() const { return (std::size_t)w * h; }
+
+	//! writes the current grid into @a g, which must have the same size
+	void get_grid(grid_t& g) const
+	{
+		for(const point& p : g.points())
+		 g[p] = bit(p.x, p.y);
+	}
+};
+
+}}
+
+#endif // BITSLICED_H
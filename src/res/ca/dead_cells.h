@@ -21,6 +21,10 @@
 #ifndef DEAD_CELLS_H
 #define DEAD_CELLS_H
 
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
 #include "ca.h"
 #include "grid.h"
 
@@ -40,9 +44,92 @@ class dead_cell_scan
 	using grid_t = _grid_t<Traits, CellTraits>;
 
 	const cell_t num_states;
+	const unsigned n_threads;
 
 	const n_t &n_in, &n_out;
 
+	//! passivity, keyed by pattern_key()
+	std::unordered_map<uint64_t, bool> passive_memo;
+
+	//! encodes which cells of n_in are dead, and their states:
+	//! one digit per cell, base num_states+1, 0 means not dead
+	//! @note dead cells with invalid states (like the border symbol)
+	//!   are treated as not dead, i.e. all their states are tried
+	uint64_t pattern_key(const grid_t& src, const grid_t& dead,
+		const point& p) const
+	{
+		uint64_t key = 0, digit = 1;
+		for(const point& np : n_in)
+		{
+			const cell_t c = src[p+np];
+			if(dead[p+np] >= cell_dead && c >= 0 && c < num_states)
+			 key += digit * (c + 1);
+			digit *= num_states + 1;
+		}
+		return key;
+	}
+
+	//! checks whether a cell with the neighbourhood pattern @a key can
+	//! never get active, for all states of the non-dead neighbours
+	//! @note thread safe, @a tmp_grid must have dimension n_in.dim()
+	bool check_passive(uint64_t key, grid_t& tmp_grid) const
+	{
+		// TODO: grids should allow negative values for indices
+		const point tmp_center = n_in.center();
+		tmp_grid.reset(0);
+
+		std::vector<point> not_dead;
+		for(const point& np : n_in)
+		{
+			const uint64_t d = key % (num_states + 1);
+			key /= num_states + 1;
+			if(d)
+			 tmp_grid[tmp_center + np] = d - 1;
+			else
+			 not_dead.push_back(tmp_center + np);
+		}
+
+		// like calc.is_cell_active(), which is not thread safe
+		const auto& is_not_active = [&](const grid_t& _tmp_grid)
+		{
+			bitgrid_t next;
+			calc.next_state(_tmp_grid, tmp_center, next);
+			for(const auto& np : counted(n_out))
+			if((cell_t)next[_point<bitgrid_traits>(np.id(), 0)]
+				!= _tmp_grid[tmp_center + np])
+			 return false;
+			return true;
+		};
+
+		return iterate_grid_bool(tmp_grid, not_dead, num_states,
+			is_not_active);
+	}
+
+	//! computes passive_memo for all @a keys, in parallel
+	void check_passive_all(const std::vector<uint64_t>& keys)
+	{
+		std::vector<char> res(keys.size());
+		const unsigned n_workers = std::max<std::size_t>(1,
+			std::min<std::size_t>(n_threads, keys.size() >> 4));
+
+		const auto work = [&](unsigned id)
+		{
+			grid_t tmp_grid(n_in.dim(), 0);
+			for(std::size_t i = id; i < keys.size(); i += n_workers)
+			 res[i] = check_passive(keys[i], tmp_grid);
+		};
+
+		std::vector<std::thread> threads;
+		for(unsigned id = 1; id < n_workers; ++id)
+		 threads.emplace_back(work, id);
+		work(0);
+		for(std::thread& t : threads)
+		 t.join();
+
+		for(std::size_t i = 0; i < keys.size(); ++i)
+		 passive_memo.emplace(keys[i], res[i]);
+	}
+
 public:
 
 	enum states
@@ -54,9 +141,13 @@ public:
 		cell_dead_state = 3
 	};
 
-	dead_cell_scan(const calculator_t& calc, const cell_t& num_states) :
+	//! @param n_threads number of threads, 0 for hardware concurrency
+	dead_cell_scan(const calculator_t& calc, const cell_t& num_states,
+		unsigned n_threads = 0) :
 		calc(calc),
 		num_states(num_states),
+		n_threads(n_threads ? n_threads
+			: std::max(1u, std::thread::hardware_concurrency())),
 		n_in(calc.n_in()),
 		n_out(calc.n_out())
 	{
@@ -85,7 +176,8 @@ public:
 		std::vector<point> killed[2];
 
 		// step 2: mark dead states + inner border dead states
-		for(const point& p : src.internal_dim())
+		const point bw(calc.border_width(), calc.border_width());
+		for(const point& p : rect(point::zero() - bw, max + bw))
 		{
 			const auto mark_killed = [&](const point& p) {
 				killed[1].push_back(p);
@@ -103,48 +195,48 @@ public:
 
 
 		// step 3: mark passive
-		grid_t tmp_grid(n_in.dim(), 0);
-		point tmp_center = n_in.center();
-
-		const auto check_passive = [&](const point& p)
-		{
-			// TODO: grids should allow negative values for indices
-
-			tmp_grid.reset(0);
-
-			std::vector<point> not_dead;
-
-			for(const point& np : n_in)
-			if(dead[p+np] >= cell_dead) {
-				tmp_grid[tmp_center + np] = src[p+np];
-			}
-			else
-			 not_dead.push_back(tmp_center + np);
-
-			const auto& is_not_active = [&](const grid_t& _tmp_grid){
-				return !calc.is_cell_active(_tmp_grid, tmp_center);
-			};
-
-			return iterate_grid_bool(tmp_grid, not_dead, num_states,
-				is_not_active);
-		};
-
+		// only cells >= cell_dead are fixed in the checks, so the
+		// candidates of one round are independent of each other
+		std::vector<point> candidates;
+		std::vector<uint64_t> keys, new_keys;
 		int round = 0;
 
 		do
 		{
 			++round;
-			std::set<point> candidates = n_in(killed[round & 1]); // TODO: inverse!
+
+			candidates.clear();
+			for(const point& k : killed[round & 1])
+			for(const point& np : n_in) // TODO: inverse!
+			{
+				const point p = k + np;
+				if(dead.contains(p) && dead[p] < cell_passive)
+				 candidates.push_back(p);
+			}
+			std::sort(candidates.begin(), candidates.end());
+			candidates.erase(std::unique(candidates.begin(),
+				candidates.end()), candidates.end());
 
 			killed[round & 1].clear();
 
+			keys.clear();
+			new_keys.clear();
 			for(const point& p : candidates)
 			{
-				if(dead[p] < cell_passive && check_passive(p))
-				{
-					dead[p] = cell_passive;
-					killed[(round + 1) & 1].push_back(p);
-				}
+				keys.push_back(pattern_key(src, dead, p));
+				if(!passive_memo.count(keys.back()))
+				 new_keys.push_back(keys.back());
+			}
+			std::sort(new_keys.begin(), new_keys.end());
+			new_keys.erase(std::unique(new_keys.begin(),
+				new_keys.end()), new_keys.end());
+			check_passive_all(new_keys);
+
+			for(std::size_t i = 0; i < candidates.size(); ++i)
+			if(passive_memo.at(keys[i]))
+			{
+				dead[candidates[i]] = cell_passive;
+				killed[(round + 1) & 1].push_back(candidates[i]);
 			}
 
 		} while(killed[(round + 1) & 1].size()) ;
@@ -0,0 +1,349 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+//! @file hashlife.h memoised quadtree simulation (hashlife) of
+//!   synchronous table CAs
+
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "ca.h"
+#include "ca_table.h"
+#include "grid.h"
+
+namespace sca { namespace ca {
+
+/**
+ * @brief Simulates a synchronous table CA using hashlife.
+ *
+ * The grid is stored as a quadtree whose nodes are canonical, i.e.
+ * equal subtrees are stored only once. For each node of side 2^k, the
+ * center of side 2^(k-1) after 2^(k-2) rounds is computed once and
+ * memoised, so repetitive patterns can be advanced by large numbers
+ * of rounds quickly.
+ *
+ * Cells outside of the grid have a special state which never changes.
+ * Cells next to it get state 0, like in simulator_t, where the table
+ * yields 0 for neighbourhoods touching the border.
+ * Only CAs writing only the center cell and reading only cells within
+ * distance 1 are supported.
+ */
+template<class Traits, class CellTraits>
+class hashlife_t
+{
+	using calculator_t = _calculator_t<table_t, Traits, CellTraits>;
+	using cell_t = typename CellTraits::cell_t;
+	using point = _point<Traits>;
+	using dimension = _dimension<Traits>;
+	using grid_t = _grid_t<Traits, CellTraits>;
+
+	//! state of cells outside of the grid
+	static constexpr cell_t outside = std::numeric_limits<cell_t>::min();
+
+	struct node_t
+	{
+		//! children nw, ne, sw, se, or nullptr for single cells
+		std::array<const node_t*, 4> q;
+		cell_t state; //!< only for single cells
+		unsigned level; //!< the node has side 2^level
+		//! memoised center after 2^result_log rounds
+		mutable const node_t* result = nullptr;
+		mutable unsigned result_log = 0;
+		node_t(const std::array<const node_t*, 4>& q, cell_t state,
+			unsigned level) : q(q), state(state), level(level) {}
+	};
+
+	struct hash_t
+	{
+		std::size_t operator()(const std::array<const node_t*, 4>& q) const
+		{
+			std::size_t h = 0;
+			for(const node_t* n : q)
+			 h = h * 0x9e3779b97f4a7c15ull + (std::size_t)n;
+			return h ^ (h >> 29);
+		}
+	};
+
+	const table_t& table;
+	const dimension dim; //!< human dimension of the grid
+	const bool writes_center;
+
+	std::deque<node_t> nodes; //!< owns all nodes
+	std::unordered_map<std::array<const node_t*, 4>, const node_t*,
+		hash_t> inner;
+	std::map<cell_t, const node_t*> leaves;
+	std::vector<const node_t*> outside_nodes; //!< by level
+
+	const node_t* root;
+	std::int64_t origin = 0; //!< position of the grid in root, x and y
+	unsigned step_log = 0; //!< rounds per call of step() for big nodes
+	std::size_t max_nodes = 1 << 22;
+
+	const node_t* leaf(cell_t state)
+	{
+		auto itr = leaves.find(state);
+		if(itr == leaves.end())
+		{
+			nodes.emplace_back(std::array<const node_t*, 4>{{}},
+				state, 0);
+			itr = leaves.emplace(state, &nodes.back()).first;
+		}
+		return itr->second;
+	}
+
+	const node_t* make(const node_t* nw, const node_t* ne,
+		const node_t* sw, const node_t* se)
+	{
+		const std::array<const node_t*, 4> q {{ nw, ne, sw, se }};
+		auto itr = inner.find(q);
+		if(itr == inner.end())
+		{
+			nodes.emplace_back(q, 0, nw->level + 1);
+			itr = inner.emplace(q, &nodes.back()).first;
+		}
+		return itr->second;
+	}
+
+	const node_t* outside_node(unsigned level)
+	{
+		if(outside_nodes.empty())
+		 outside_nodes.push_back(leaf(outside));
+		while(outside_nodes.size() <= level)
+		{
+			const node_t* o = outside_nodes.back();
+			outside_nodes.push_back(make(o, o, o, o));
+		}
+		return outside_nodes[level];
+	}
+
+	//! the inner node of half the side
+	const node_t* center(const node_t* n)
+	{
+		return make(n->q[0]->q[3], n->q[1]->q[2],
+			n->q[2]->q[1], n->q[3]->q[0]);
+	}
+
+	//! node of twice the side, with @a n in the center
+	const node_t* expand(const node_t* n)
+	{
+		const node_t* o = outside_node(n->level - 1);
+		return make(make(o, o, o, n->q[0]), make(o, o, n->q[1], o),
+			make(o, n->q[2], o, o), make(n->q[3], o, o, o));
+	}
+
+	//! one round for the inner 2x2 cells of a 4x4 node, using the table
+	const node_t* base_step(const node_t* n)
+	{
+		cell_t c[16];
+		for(unsigned y = 0; y < 4; ++y)
+		for(unsigned x = 0; x < 4; ++x)
+		 c[(y << 2) + x] = n->q[((y >> 1) << 1) + (x >> 1)]
+			->q[((y & 1) << 1) + (x & 1)]->state;
+
+		const node_t* res[4];
+		for(unsigned y = 1; y < 3; ++y)
+		for(unsigned x = 1; x < 3; ++x)
+		{
+			const cell_t* const ptr = c + (y << 2) + x;
+			cell_t next = *ptr;
+			uint64_t key;
+			if(next != outside && writes_center)
+			 next = table.template neighbourhood_key<Traits, CellTraits>
+				(ptr, dimension(4, 4), key)
+				? (cell_t)table.next_state_of_key(key) : 0;
+			res[((y - 1) << 1) + x - 1] = leaf(next);
+		}
+		return make(res[0], res[1], res[2], res[3]);
+	}
+
+	//! the center of @a n after 2^min(level-2, step_log) rounds
+	const node_t* step(const node_t* n)
+	{
+		const unsigned log = std::min(n->level - 2, step_log);
+		if(n->result && n->result_log == log)
+		 return n->result;
+
+		const node_t* res;
+		if(n->level == 2)
+		 res = base_step(n);
+		else
+		{
+			const auto& a = n->q;
+			const node_t* m[9] = {
+				a[0],
+				make(a[0]->q[1], a[1]->q[0], a[0]->q[3], a[1]->q[2]),
+				a[1],
+				make(a[0]->q[2], a[0]->q[3], a[2]->q[0], a[2]->q[1]),
+				center(n),
+				make(a[1]->q[2], a[1]->q[3], a[3]->q[0], a[3]->q[1]),
+				a[2],
+				make(a[2]->q[1], a[3]->q[0], a[2]->q[3], a[3]->q[2]),
+				a[3] };
+
+			// at full speed, both halves of the time are memoised,
+			// otherwise, only the second one runs
+			const bool full = (log == n->level - 2);
+			const node_t* r[9];
+			for(int i = 0; i < 9; ++i)
+			 r[i] = full ? step(m[i]) : center(m[i]);
+
+			res = make(step(make(r[0], r[1], r[3], r[4])),
+				step(make(r[1], r[2], r[4], r[5])),
+				step(make(r[3], r[4], r[6], r[7])),
+				step(make(r[4], r[5], r[7], r[8])));
+		}
+
+		n->result = res;
+		n->result_log = log;
+		return res;
+	}
+
+	//! builds the node of side 2^level at grid position (@a x, @a y)
+	const node_t* build(const grid_t& g, unsigned level,
+		std::int64_t x, std::int64_t y)
+	{
+		const std::int64_t side = (std::int64_t)1 << level;
+		if(x >= dim.dx() || y >= dim.dy() || x + side <= 0 || y + side <= 0)
+		 return outside_node(level);
+		else if(!level)
+		 return leaf(g[point(x, y)]);
+		else
+		{
+			const std::int64_t h = side >> 1;
+			return make(build(g, level - 1, x, y),
+				build(g, level - 1, x + h, y),
+				build(g, level - 1, x, y + h),
+				build(g, level - 1, x + h, y + h));
+		}
+	}
+
+	void write(const node_t* n, grid_t& g, std::int64_t x, std::int64_t y) const
+	{
+		const std::int64_t side = (std::int64_t)1 << n->level;
+		if(x >= dim.dx() || y >= dim.dy() || x + side <= 0 || y + side <= 0)
+		 return;
+		else if(!n->level)
+		 g[point(x, y)] = n->state;
+		else
+		{
+			const std::int64_t h = side >> 1;
+			write(n->q[0], g, x, y);
+			write(n->q[1], g, x + h, y);
+			write(n->q[2], g, x, y + h);
+			write(n->q[3], g, x + h, y + h);
+		}
+	}
+
+	const node_t* copy(const node_t* n,
+		std::unordered_map<const node_t*, const node_t*>& moved)
+	{
+		auto itr = moved.find(n);
+		if(itr != moved.end())
+		 return itr->second;
+		const node_t* res = n->level
+			? make(copy(n->q[0], moved), copy(n->q[1], moved),
+				copy(n->q[2], moved), copy(n->q[3], moved))
+			: leaf(n->state);
+		moved.emplace(n, res);
+		return res;
+	}
+
+	//! drops all nodes (and memoised results) not used by the root
+	void collect()
+	{
+		std::deque<node_t> old;
+		old.swap(nodes);
+		inner.clear();
+		leaves.clear();
+		outside_nodes.clear();
+		std::unordered_map<const node_t*, const node_t*> moved;
+		root = copy(root, moved);
+	}
+
+public:
+	//! whether @a calc can be simulated by hashlife
+	static bool supports(const calculator_t& calc)
+	{
+		for(const point& p : calc.n_in())
+		if(p.x < -1 || p.x > 1 || p.y < -1 || p.y > 1)
+		 return false;
+		return calc.n_out().size() == 0 || (calc.n_out().size() == 1
+			&& calc.n_out()[0] == point(0, 0));
+	}
+
+	//! @param g the start grid, its human area is simulated
+	hashlife_t(const calculator_t& calc, const grid_t& g) :
+		table(calc),
+		dim(g.human_dim()),
+		writes_center(calc.n_out().size() != 0)
+	{
+		if(!supports(calc))
+		 throw "Hashlife only supports CAs writing to v "
+			"with neighbourhoods of radius 1.";
+		unsigned level = 2;
+		while(((std::int64_t)1 << level) < std::max(dim.dx(), dim.dy()))
+		 ++level;
+		root = build(g, level, 0, 0);
+	}
+
+	//! sets the number of nodes which triggers a garbage collection
+	void set_max_nodes(std::size_t n) { max_nodes = n; }
+	std::size_t num_nodes() const { return nodes.size(); }
+
+	//! advances the grid by 2^@a log rounds
+	void advance_log(unsigned log)
+	{
+		if(nodes.size() > max_nodes)
+		 collect();
+		// the root is expanded once more below, and the expanded
+		// node must be able to advance 2^log rounds
+		while(root->level < log + 1)
+		{
+			origin += (std::int64_t)1 << (root->level - 1);
+			root = expand(root);
+		}
+		step_log = log;
+		root = step(expand(root));
+	}
+
+	//! advances the grid by @a rounds rounds
+	void advance(std::uint64_t rounds)
+	{
+		for(unsigned log = 0; rounds; ++log, rounds >>= 1)
+		if(rounds & 1)
+		 advance_log(log);
+	}
+
+	//! writes the current state into the human area of @a g
+	void get_grid(grid_t& g) const { write(root, g, -origin, -origin); }
+};
+
+}}
+
+#endif // HASHLIFE_H
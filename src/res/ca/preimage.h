@@ -21,125 +21,347 @@
 #ifndef PREIMAGE_H
 #define PREIMAGE_H
 
-#include "ca.h"
-#include <iostream>
-#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 
-// TODO: cpp file
+#include "ca.h"
 
 namespace sca { namespace ca {
 
-// TODO: stackoverflow
-int my_pow(int x, int p)
+/**
+ * @brief Finds all preimages of a configuration.
+ *
+ * The outer ring of the input (as wide as the neighbourhood's radius) is
+ * assumed to be unchanged; all cells inside are unknowns which must map
+ * onto the input.
+ *
+ * The unknowns are assigned in row-major order. Since the neighbourhood
+ * is sorted linewise, each assignment completes a prefix (in n_in order)
+ * of the neighbourhoods of all cells reading it. From the table, we
+ * precompute which prefixes can still be completed to a neighbourhood
+ * with the wanted output, so dead branches are cut as early as possible.
+ *
+ * The search tree is split into subtrees which are processed by
+ * multiple threads.
+ */
+template<class Solver, class Traits, class CellTraits>
+class preimage_finder_t
 {
-	if (p == 0) return 1;
-	if (p == 1) return x;
+	using calculator_t = _calculator_t<Solver, Traits, CellTraits>;
+	using cell_t = typename CellTraits::cell_t;
+	using coord_t = typename Traits::coord_t;
+	using point = _point<Traits>;
+	using grid_t = _grid_t<Traits, CellTraits>;
 
-	int tmp = my_pow(x, p/2);
-	if (p%2 == 0) return tmp * tmp;
-	else return x * tmp * tmp;
-}
+	//! check for a reader, when one of its neighbours is assigned
+	struct check_t
+	{
+		std::size_t center; //!< index of the reader in cells
+		std::size_t length; //!< number of n_in cells known after this
+	};
 
-//! just for debugging. reentrancy not dangered
-point max_point = point (0, 0);
+	const grid_t& input;
+	const std::size_t num_states;
+	const coord_t width, height;
+	std::size_t n_size;
 
-//! fills in possible grids for preimages from top-left to bottom right
-template<class Solver, class Traits, class CellTraits>
-void _dump_preimages(const _calculator_t<Solver, Traits, CellTraits>& ca,
-	const _grid_t<Traits, CellTraits>& input,
-	std::size_t num_states,
-	_grid_t<Traits, CellTraits>& constraints,
-	const std::ostream& ofs = std::cout,
-	_point<Traits> this_point = _point<Traits>(1, 1))
-{
+	//! for each output and prefix length, whether the prefix (encoded
+	//! base num_states, first cell lowest) can still produce the output
+	std::vector<std::vector<std::vector<bool>>> feasible;
 
-	using point = _point<Traits>;
-	using grid_t = _grid_t<Traits, CellTraits>;
-	grid_t src_grid(ca.n_in().dim(), 0);
-	const point c = ca.n_in().center();
+	std::vector<cell_t> start_cells; //!< ring set, unknowns are -1
+	std::vector<std::size_t> unknowns; //!< in row-major order
+	std::vector<std::vector<std::size_t>> neighbours; //!< per cell index
+	std::vector<std::vector<check_t>> checks; //!< per unknown
+	//! whether the unknowns reading only fixed cells get their output
+	bool fixed_readers_ok = true;
 
-//	std::cerr << this_point << std::endl;
+	std::size_t idx(coord_t x, coord_t y) const { return y * width + x; }
 
-	if(this_point.y == static_cast<typename Traits::coord_t>(input.dy() - 1))
+	bool prefix_ok(const std::vector<cell_t>& cells, const check_t& c) const
 	{
-		// recursion is finished
-		std::cout << constraints;
+		const std::vector<std::size_t>& nb = neighbours[c.center];
+		std::size_t code = 0;
+		for(std::size_t i = c.length; i > 0; --i)
+		 code = code * num_states + cells[nb[i - 1]];
+		return feasible[input_at(c.center)][c.length - 1][code];
 	}
-	else
+
+	cell_t input_at(std::size_t i) const {
+		return input[point(i % width, i / width)]; }
+
+	//! tries to assign the @a depth'th unknown, starting at state @a s
+	bool assign(std::vector<cell_t>& cells, std::size_t depth,
+		cell_t s) const
 	{
-		if(this_point > max_point)
+		cell_t& cell = cells[unknowns[depth]];
+		for(; s < (cell_t)num_states; ++s)
 		{
-			max_point = this_point;
-			std::cerr << "NEW MAX: " << this_point << std::endl;
+			cell = s;
+			bool ok = true;
+			for(const check_t& c : checks[depth])
+			if(!prefix_ok(cells, c))
+			{
+				ok = false;
+				break;
+			}
+			if(ok)
+			 return true;
 		}
+		cell = -1;
+		return false;
+	}
 
-		// fill src_grid
-		std::vector<point> variables;
+	//! iterative dfs over the unknowns from @a first on
+	template<class Functor>
+	std::size_t run_subtree(std::vector<cell_t>& cells, std::size_t first,
+		const Functor& ftor) const
+	{
+		std::size_t found = 0;
+		if(first == unknowns.size())
+		{
+			ftor(cells);
+			return 1;
+		}
 
-		for(const point& np : ca.n_in().get_rect())
+		std::size_t depth = first;
+		bool descend = assign(cells, depth, 0);
+		while(true)
 		{
-			if(constraints[this_point + np] < 0)
-			 variables.push_back(np);
+			if(descend)
+			{
+				if(depth + 1 == unknowns.size())
+				{
+					ftor(cells);
+					++found;
+					descend = false;
+				}
+				else
+				 descend = assign(cells, ++depth, 0);
+			}
 			else
-			 src_grid[c + np] = constraints[this_point + np];
+			{
+				// try the next state at this depth, or backtrack
+				const cell_t cur = cells[unknowns[depth]];
+				if(cur >= 0 && assign(cells, depth, cur + 1))
+				 descend = true;
+				else if(depth == first)
+				 break;
+				else
+				 --depth;
+			}
 		}
+		return found;
+	}
+
+	//! all valid assignments of the first @a depth unknowns
+	std::vector<std::vector<cell_t>> split(std::size_t min_tasks,
+		std::size_t& depth) const
+	{
+		std::vector<std::vector<cell_t>> tasks { start_cells };
+		for(depth = 0; depth < unknowns.size() && tasks.size() < min_tasks;
+			++depth)
+		{
+			std::vector<std::vector<cell_t>> next;
+			for(std::vector<cell_t>& t : tasks)
+			for(cell_t s = 0; assign(t, depth, s); s = t[unknowns[depth]] + 1)
+			 next.push_back(t);
+			tasks = std::move(next);
+		}
+		return tasks;
+	}
+
+public:
+	preimage_finder_t(const calculator_t& ca, const grid_t& input,
+		std::size_t num_states) :
+		input(input),
+		num_states(num_states),
+		width(input.dx()),
+		height(input.dy())
+	{
+		const auto& n_in = ca.n_in();
+		n_size = n_in.size();
 
-		point next_point = this_point + point(1, 0);
-		if(next_point.x == static_cast<typename Traits::coord_t>(input.dx() - 1))
+		coord_t radius = 0;
+		for(const point& np : n_in)
+		 radius = std::max(radius, std::max(std::abs(np.x), std::abs(np.y)));
+
+		/*
+		 * precompute feasible prefixes from the table
+		 */
+		std::size_t n_codes = 1;
+		for(std::size_t i = 0; i < n_size; ++i)
 		{
-			next_point.x = 1;
-			++next_point.y;
+			n_codes *= num_states;
+			if(n_codes > (1 << 26))
+			 throw "Neighbourhood too large for preimage search.";
 		}
 
-		std::size_t remains = variables.size();
-		std::size_t mask_max = my_pow(num_states, remains);
+		feasible.resize(num_states);
+		for(auto& f : feasible)
+		{
+			f.resize(n_size);
+			std::size_t len = 1;
+			for(std::size_t k = 0; k < n_size; ++k)
+			 f[k].resize(len *= num_states, false);
+		}
 
-		for(std::size_t mask = 0; mask < mask_max; ++mask)
+		grid_t src_grid(n_in.dim(), 0);
+		const point c = n_in.center();
+		for(std::size_t code = 0; code < n_codes; ++code)
 		{
-			std::size_t mask_cp = mask;
-			for(std::size_t count = 0; count < remains; ++count)
+			std::size_t rest = code;
+			for(const point& np : n_in)
 			{
-				const point& _p = variables[count];
-				constraints[this_point + _p] = src_grid[c + _p] = mask_cp % num_states;
-				mask_cp /= num_states;
+				src_grid[c + np] = rest % num_states;
+				rest /= num_states;
 			}
 
-			bitgrid_t b_res(2 /*TODO!*/, convert<bitgrid_traits>(src_grid.human_dim()), 0, 0, 0);
+			bitgrid_t b_res(2 /*TODO!*/,
+				convert<bitgrid_traits>(src_grid.human_dim()), 0, 0, 0);
 			ca.next_state(src_grid, c, b_res);
-			uint64_t res = b_res[_point<bitgrid_traits>(0, 0)];
-			if(static_cast<typename Traits::coord_t>(res) == input[this_point])
+			const uint64_t res = b_res[_point<bitgrid_traits>(0, 0)];
+			if(res < num_states)
+			{
+				std::size_t mod = 1;
+				for(std::size_t k = 0; k < n_size; ++k)
+				 feasible[res][k][code % (mod *= num_states)] = true;
+			}
+		}
+
+		/*
+		 * cells, unknowns and checks
+		 */
+		start_cells.assign(width * height, -1);
+		std::vector<std::size_t> order(width * height, 0); // 0 = fixed
+		for(coord_t y = 0; y < height; ++y)
+		for(coord_t x = 0; x < width; ++x)
+		{
+			const bool fixed = x < radius || y < radius
+				|| x >= width - radius || y >= height - radius;
+			if(fixed)
+			 start_cells[idx(x, y)] = input[point(x, y)];
+			else
 			{
-				std::cerr << " percentage: " << this_point << ", " << mask << " of " << mask_max << std::endl;
-				_dump_preimages(ca, input, num_states, constraints, ofs, next_point);
+				unknowns.push_back(idx(x, y));
+				order[idx(x, y)] = unknowns.size();
 			}
 		}
 
-		for(const point& np : variables)
-		 constraints[this_point + np] = -1;
+		for(const point& p : input.points())
+		if(input[p] < 0 || input[p] >= (cell_t)num_states)
+		 throw "Input contains states out of range.";
 
+		neighbours.resize(width * height);
+		checks.resize(unknowns.size());
+		for(const std::size_t& u : unknowns)
+		{
+			const coord_t x = u % width, y = u / width;
+			std::vector<std::size_t>& nb = neighbours[u];
+			for(const point& np : n_in)
+			 nb.push_back(idx(x + np.x, y + np.y));
+
+			// neighbour k is assigned in row-major order, so after it,
+			// all n_in cells up to the next unknown one are known
+			bool reads_unknown = false;
+			for(std::size_t k = 0; k < n_size; ++k)
+			if(order[nb[k]])
+			{
+				std::size_t length = k + 1;
+				while(length < n_size && !order[nb[length]])
+				 ++length;
+				checks[order[nb[k]] - 1].push_back(check_t { u, length });
+				reads_unknown = true;
+			}
+
+			// no assignment checks u, e.g. if n_in lacks the center
+			if(!reads_unknown && n_size
+				&& !prefix_ok(start_cells, check_t { u, n_size }))
+			 fixed_readers_ok = false;
+		}
 	}
-}
 
+	//! number of unknown cells
+	std::size_t num_unknowns() const { return unknowns.size(); }
+
+	/**
+	 * @brief calls @a ftor(grid) for each preimage
+	 * @param n_threads number of threads, 0 for hardware concurrency
+	 * @note @a ftor is called under a lock. for 1 thread, the preimages
+	 *   are ordered lexicographically, row by row, otherwise randomly
+	 * @return number of preimages
+	 */
+	template<class Functor>
+	std::size_t for_each(const Functor& ftor, unsigned n_threads = 0) const
+	{
+		std::mutex ftor_mutex;
+		const auto cb = [&](const std::vector<cell_t>& cells)
+		{
+			grid_t res(input.human_dim(), 0);
+			for(coord_t y = 0; y < height; ++y)
+			for(coord_t x = 0; x < width; ++x)
+			 res[point(x, y)] = cells[idx(x, y)];
+			std::lock_guard<std::mutex> lock(ftor_mutex);
+			ftor(res);
+		};
+		return run(cb, n_threads);
+	}
+
+	//! counts the preimages, see @a for_each
+	std::size_t count(unsigned n_threads = 0) const
+	{
+		return run([](const std::vector<cell_t>&){}, n_threads);
+	}
+
+private:
+	template<class Functor>
+	std::size_t run(const Functor& ftor, unsigned n_threads) const
+	{
+		if(!fixed_readers_ok)
+		 return 0;
+		if(!n_threads)
+		 n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+		std::size_t depth;
+		std::vector<std::vector<cell_t>> tasks = split(
+			(n_threads == 1) ? 1 : (n_threads << 4), depth);
+
+		std::atomic<std::size_t> next_task(0), found(0);
+		const auto work = [&]()
+		{
+			std::size_t local = 0;
+			for(std::size_t t = next_task++; t < tasks.size(); t = next_task++)
+			 local += run_subtree(tasks[t], depth, ftor);
+			found += local;
+		};
+
+		std::vector<std::thread> threads;
+		for(unsigned i = 1; i < n_threads; ++i)
+		 threads.emplace_back(work);
+		work();
+		for(std::thread& t : threads)
+		 t.join();
+
+		return found;
+	}
+};
+
+//! prints all preimages of @a input to @a ofs
+//! @param n_threads see preimage_finder_t::for_each(), the order of the
+//!   preimages is only fixed for the default 1
 template<class Solver, class Traits, class CellTraits>
-void dump_preimages(const _calculator_t<Solver, Traits, CellTraits>& ca,
-	const _grid_t<Traits, CellTraits> input,
+std::size_t dump_preimages(const _calculator_t<Solver, Traits, CellTraits>& ca,
+	const _grid_t<Traits, CellTraits>& input,
 	std::size_t num_states,
-	const std::ostream& ofs = std::cout,
-	_point<Traits> this_point = _point<Traits>(1, 1))
+	std::ostream& ofs = std::cout,
+	unsigned n_threads = 1)
 {
-	_grid_t<Traits, CellTraits> constraints(input.human_dim(), 0, -1, 0);
-	// draw border - is known not to have changed
-	for(const _point<Traits>& p : constraints.points())
-	if(p.x == 0
-		|| p.x == static_cast<typename Traits::coord_t>(constraints.dx() - 1)
-		|| p.y == 0
-		|| p.y == static_cast<typename Traits::coord_t>(constraints.dy() - 1))
-	 constraints[p] = input[p];
-
-	//std::cerr << constraints << std::endl;
-
-	// start recursion
-	_dump_preimages(ca, input, num_states, constraints, ofs, this_point);
+	const preimage_finder_t<Solver, Traits, CellTraits>
+		finder(ca, input, num_states);
+	return finder.for_each([&](const _grid_t<Traits, CellTraits>& g) {
+		ofs << g; }, n_threads);
 }
 
 } }
@@ -0,0 +1,151 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+//! @file sparse_simulator.h synchronous simulation on unbounded,
+//!   sparse boards
+
+#ifndef SPARSE_SIMULATOR_H
+#define SPARSE_SIMULATOR_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "ca.h"
+#include "sparse_board.h"
+
+namespace sca { namespace ca {
+
+/**
+ * @brief Synchronous simulator like simulator_t, but on a sparse_board_t.
+ *
+ * Like simulator_t, each round only computes cells next to cells which
+ * changed in the last round. Since the board can not be read through
+ * pointers, the input neighbourhood of each such cell is gathered into
+ * a small buffer first.
+ *
+ * All cells which are never set are 0, so 0 must be quiescent, i.e.
+ * a cell whose neighbourhood is all 0 stays 0. Only CAs which write no
+ * cell or only the center cell are supported, like for
+ * tiled_transform_t. Cells far from non-zero cells are never computed,
+ * so the CA may not read the coordinates, see Solver::uses_position().
+ */
+template<class Solver, class Traits, class CellTraits>
+class sparse_simulator_t
+{
+	using calculator_t = _calculator_t<Solver, Traits, CellTraits>;
+	using cell_t = typename CellTraits::cell_t;
+	using coord_t = typename Traits::coord_t;
+	using point = _point<Traits>;
+	using dimension = _dimension<Traits>;
+	using board_t = sparse_board_t<Traits, CellTraits>;
+
+	const calculator_t& calc;
+	board_t _board;
+	const coord_t bw;
+	const dimension n_dim; //!< dimension of the gather buffer
+	std::vector<cell_t> buf;
+	std::vector<point> candidates;
+	std::vector<std::pair<point, cell_t>> changes; //!< of the last round
+	std::vector<point> rev_n_in; //!< cells which read a changed cell
+
+	cell_t next_state(const point& p)
+	{
+		_board.gather(point(p.x - bw, p.y - bw), n_dim, buf.data());
+		cell_t* const center = buf.data() + bw * n_dim.dx() + bw;
+		cell_t res = *center;
+		calc.next_state(center, p, n_dim, &res, dimension(1, 1));
+		return res;
+	}
+
+public:
+	static bool supports(const calculator_t& calc)
+	{
+		return !calc.uses_position() && (calc.n_out().size() == 0
+			|| (calc.n_out().size() == 1
+			&& calc.n_out()[0] == point(0, 0)));
+	}
+
+	sparse_simulator_t(const calculator_t& calc) :
+		calc(calc),
+		bw(calc.border_width()),
+		n_dim(2 * bw + 1, 2 * bw + 1),
+		buf(n_dim.area())
+	{
+		if(!supports(calc))
+		 throw "Sparse simulation only supports CAs writing to v "
+			"and not reading the position.";
+		for(const point& np : calc.n_in())
+		 rev_n_in.push_back(point(-np.x, -np.y));
+		rev_n_in.push_back(point(0, 0));
+		if(next_state(point(0, 0)))
+		 throw "Sparse simulation needs 0 to be a quiescent state.";
+	}
+
+	board_t& board() { return _board; }
+	const board_t& board() const { return _board; }
+
+	//! prepares the first round, must be called after setting the board
+	void finalize()
+	{
+		candidates.clear();
+		_board.for_each_non_zero([&](const point& p, cell_t ) {
+			for(const point& np : rev_n_in)
+			 candidates.push_back(p + np);
+		});
+		changes.clear();
+	}
+
+	//! returns false iff the last round changed no cell
+	bool can_run() const { return !candidates.empty(); }
+
+	//! runs one synchronous round
+	void run_once()
+	{
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()),
+			candidates.end());
+
+		changes.clear();
+		if(calc.n_out().size())
+		for(const point& p : candidates)
+		{
+			const cell_t v = next_state(p);
+			if(v != _board[p])
+			 changes.emplace_back(p, v);
+		}
+
+		candidates.clear();
+		for(const auto& c : changes)
+		{
+			_board.set(c.first, c.second);
+			for(const point& np : rev_n_in)
+			 candidates.push_back(c.first + np);
+		}
+		_board.release_empty();
+	}
+
+	//! number of cells which changed in the last round
+	std::size_t num_changes() const { return changes.size(); }
+};
+
+}}
+
+#endif // SPARSE_SIMULATOR_H
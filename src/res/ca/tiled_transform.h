@@ -0,0 +1,206 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+//! @file tiled_transform.h runs a synchronous CA on grids which are
+//!   streamed through in bands of rows, like images
+
+#ifndef TILED_TRANSFORM_H
+#define TILED_TRANSFORM_H
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "ca.h"
+#include "grid.h"
+
+namespace sca { namespace ca {
+
+/**
+ * @brief Applies a synchronous CA to a grid which is read and written
+ *   row by row.
+ *
+ * The grid is cut into bands of rows. Each band is extended by halo rows
+ * on both sides (iterations times the border width of the CA), such that
+ * after all iterations, the band's own rows are exact. The bands of one
+ * chunk are computed in parallel. Only the rows of the current chunk and
+ * their halos are kept in memory.
+ *
+ * Cells outside of the grid have the value @a border_fill.
+ * Only CAs which write no cell or only the center cell are supported,
+ * since others need conflict resolution (see simulator_t).
+ */
+template<class Solver, class Traits, class CellTraits>
+class tiled_transform_t
+{
+	using calculator_t = _calculator_t<Solver, Traits, CellTraits>;
+	using cell_t = typename CellTraits::cell_t;
+	using coord_t = typename Traits::coord_t;
+	using point = _point<Traits>;
+	using dimension = _dimension<Traits>;
+	using grid_t = _grid_t<Traits, CellTraits>;
+
+	const calculator_t& calc;
+	const int iterations;
+	const cell_t border_fill;
+	const coord_t halo;
+	const bool writes_center;
+	unsigned n_threads;
+	coord_t band_height;
+
+	//! one synchronous step from @a src to @a tar
+	//! @param y_offs y coordinate of the grids' first row in the full grid
+	void step(const calculator_t& c, const grid_t& src, grid_t& tar,
+		coord_t y_offs) const
+	{
+		const dimension& idim = src.internal_dim();
+		const coord_t w = src.human_dim().dx(), h = src.human_dim().dy();
+		for(coord_t y = 0; y < h; ++y)
+		{
+			const cell_t* s = &src[point(0, y)];
+			cell_t* t = &tar[point(0, y)];
+			std::copy(s, s + w, t);
+			if(writes_center)
+			for(coord_t x = 0; x < w; ++x)
+			 c.next_state(s + x, point(x, y + y_offs), idim, t + x, idim);
+		}
+	}
+
+	//! computes the rows [@a b0, @a b1) into @a out
+	//! @param window rows [@a win_y0, ...) of the input
+	void compute_band(const calculator_t& c, const std::vector<cell_t>& window,
+		coord_t win_y0, const dimension& dim, coord_t b0, coord_t b1,
+		cell_t* out) const
+	{
+		const coord_t w = dim.dx();
+		const coord_t r0 = std::max((coord_t)0, b0 - halo),
+			r1 = std::min((coord_t)dim.dy(), b1 + halo);
+		const dimension band_dim(w, r1 - r0);
+		grid_t g[2] = {
+			grid_t(band_dim, calc.border_width(), 0, border_fill),
+			grid_t(band_dim, calc.border_width(), 0, border_fill) };
+
+		for(coord_t y = r0; y < r1; ++y)
+		{
+			const cell_t* row = window.data() + (y - win_y0) * w;
+			std::copy(row, row + w, &g[0][point(0, y - r0)]);
+		}
+
+		int cur = 0;
+		for(int i = 0; i < iterations; ++i, cur ^= 1)
+		 step(c, g[cur], g[cur ^ 1], r0);
+
+		for(coord_t y = b0; y < b1; ++y)
+		{
+			const cell_t* row = &g[cur][point(0, y - r0)];
+			std::copy(row, row + w, out + (y - b0) * w);
+		}
+	}
+
+public:
+	//! whether @a calc writes no cell or only the center cell
+	static bool supports(const calculator_t& calc)
+	{
+		return calc.n_out().size() == 0 || (calc.n_out().size() == 1
+			&& calc.n_out()[0] == point(0, 0));
+	}
+
+	//! @param calc the CA, it is copied for each thread
+	//! @param n_threads number of threads, 0 means one per core
+	tiled_transform_t(const calculator_t& calc, int iterations = 1,
+		cell_t border_fill = std::numeric_limits<cell_t>::min(),
+		unsigned n_threads = 0) :
+		calc(calc),
+		iterations(iterations),
+		border_fill(border_fill),
+		halo(iterations * calc.border_width()),
+		writes_center(calc.n_out().size() != 0),
+		n_threads(n_threads ? n_threads
+			: std::max(1u, std::thread::hardware_concurrency())),
+		band_height(std::max((coord_t)64, 4 * halo))
+	{
+		if(!supports(calc))
+		 throw "Tiled transforms only support CAs writing to v.";
+	}
+
+	//! sets the number of rows computed per thread and band
+	void set_band_height(coord_t h) { band_height = std::max((coord_t)1, h); }
+
+	/**
+	 * @brief runs the transform
+	 * @param dim dimension of the full grid
+	 * @param read called as read(cell_t* rows, n), must fill the next
+	 *   n rows of the input
+	 * @param write called as write(const cell_t* rows, n) with the next
+	 *   n rows of the output
+	 */
+	template<class Read, class Write>
+	void operator()(const dimension& dim, Read&& read, Write&& write) const
+	{
+		const coord_t w = dim.dx(), h = dim.dy();
+		const coord_t chunk = band_height * n_threads;
+
+		std::vector<cell_t> window, out(chunk * w);
+		coord_t win_y0 = 0, win_y1 = 0; // rows in window
+
+		std::vector<calculator_t> calcs(n_threads - 1, calc);
+
+		for(coord_t c0 = 0; c0 < h; c0 += chunk)
+		{
+			const coord_t c1 = std::min(h, c0 + chunk);
+
+			// slide the window to [c0 - halo, c1 + halo)
+			const coord_t need0 = std::max((coord_t)0, c0 - halo),
+				need1 = std::min(h, c1 + halo);
+			window.erase(window.begin(),
+				window.begin() + (need0 - win_y0) * w);
+			win_y0 = need0;
+			window.resize((need1 - win_y0) * w);
+			read(window.data() + (win_y1 - win_y0) * w, need1 - win_y1);
+			win_y1 = need1;
+
+			// band b of the chunk is computed by thread b % n_threads
+			const coord_t bands = (c1 - c0 + band_height - 1) / band_height;
+			const auto run_thread = [&](unsigned t, const calculator_t& c) {
+				for(coord_t b = t; b < bands; b += n_threads)
+				{
+					const coord_t b0 = c0 + b * band_height,
+						b1 = std::min(c1, b0 + band_height);
+					compute_band(c, window, win_y0, dim, b0, b1,
+						out.data() + (b0 - c0) * w);
+				}
+			};
+
+			std::vector<std::thread> threads;
+			for(unsigned t = 1; t < n_threads && (coord_t)t < bands; ++t)
+			 threads.emplace_back(run_thread, t, std::cref(calcs[t - 1]));
+			run_thread(0, calc);
+			for(std::thread& th : threads)
+			 th.join();
+
+			write(out.data(), c1 - c0);
+		}
+	}
+};
+
+}}
+
+#endif // TILED_TRANSFORM_H
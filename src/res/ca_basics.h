@@ -21,6 +21,7 @@
 #ifndef CA_BASICS_H
 #define CA_BASICS_H
 
+#include <cstdint>
 #include <set>
 #include <algorithm>
 #include <array>
@@ -32,153 +33,236 @@
 namespace sca { namespace ca {
 
 /**
- * @brief This class holds input and output values of a
- * local transition function.
+ * @brief This class holds input and output values of many
+ * local transition functions ("rules") in one buffer.
  *
  * Where these values are depends on a neighborhood class,
- * which is not a part of this struct.
+ * which is not a part of this class.
+ *
+ * Each value is a field of 16 bits, where 0 means "don't care" and
+ * v+1 means value v. Four fields are packed into one 64 bit word, the
+ * first field in the highest bits. A rule is stored as its input words,
+ * followed by its output words. Comparing the words of two rules as
+ * integers thus compares them like lexicographically comparing their
+ * values, where a don't care counts as the smallest value.
  */
-class trans_t
+class trans_buffer_t
 {
-	// group parameters
-	const unsigned neighbour_size; //! size of input_vals
-	// differing parameters
-	std::vector<int> input_vals; //!< function input values
-	std::vector<bool> input_set; //!< is the value a dontcare?
-	int input_count = 0; //!< number of set bits in input_set
-	std::vector<int> output_vals; //! function output value
-
 public:
-	trans_t(const unsigned _neighbour_size)
-	:
-		neighbour_size(_neighbour_size),
-		input_vals(neighbour_size),
-		input_set(neighbour_size, false)
+	using word_t = uint64_t;
+	static constexpr unsigned field_bits = 16;
+	static constexpr unsigned fields_per_word = 64 / field_bits;
+	//! largest value which can be stored
+	static constexpr int max_value = (1 << field_bits) - 2;
+private:
+	unsigned n_in, n_out; //!< number of input/output values per rule
+	unsigned in_words, out_words, stride;
+	std::vector<word_t> buf;
+
+	static unsigned words_for(unsigned n) {
+		return (n + fields_per_word - 1) / fields_per_word; }
+	static unsigned shift(unsigned i) {
+		return (fields_per_word - 1 - i % fields_per_word) * field_bits; }
+
+	word_t* rule(std::size_t r) { return buf.data() + r * stride; }
+	const word_t* rule(std::size_t r) const {
+		return buf.data() + r * stride; }
+
+	unsigned get_field(const word_t* words, unsigned i) const {
+		return (words[i / fields_per_word] >> shift(i))
+			& ((1 << field_bits) - 1); }
+	void set_field(word_t* words, unsigned i, int val)
 	{
+		if(val < 0 || val > max_value)
+		 throw "Values of transition functions must be in [0, 65534]";
+		word_t& w = words[i / fields_per_word];
+		w = (w & ~((word_t)((1 << field_bits) - 1) << shift(i)))
+			| ((word_t)(val + 1) << shift(i));
 	}
 
-	trans_t operator=(
-		const trans_t& other)
-	{
-		assert(neighbour_size == other.neighbour_size);
-		input_vals = other.input_vals;
-		input_set = other.input_set;
-		input_count = other.input_count;
-		output_vals = other.output_vals;
-		return *this;
+	bool less_by_input(std::size_t r1, std::size_t r2) const {
+		return std::lexicographical_compare(rule(r1), rule(r1) + stride,
+			rule(r2), rule(r2) + stride);
 	}
-
-	trans_t(
-		int n_in_size,
-		int n_out_size
-		) : // TODO: 2ctors + reuse
-		neighbour_size(n_in_size),
-		input_vals(n_in_size),
-		input_set(n_in_size, false),
-		output_vals(n_out_size)
+	bool less_by_output(std::size_t r1, std::size_t r2) const
 	{
+		const word_t *w1 = rule(r1), *w2 = rule(r2);
+		return std::lexicographical_compare(w1 + in_words, w1 + stride,
+			w2 + in_words, w2 + stride)
+			|| (std::equal(w1 + in_words, w1 + stride, w2 + in_words)
+				&& std::lexicographical_compare(w1, w1 + in_words,
+					w2, w2 + in_words));
 	}
 
-	void set_neighbour(int neighbour_id, int val)
+	//! reorders the rules, @a less compares two rule indices
+	template<class Less>
+	void sort_by(const Less& less)
 	{
-		input_vals[neighbour_id] = val;
-		if(!input_set[neighbour_id])
-		{
-			input_set[neighbour_id] = true;
-			++input_count;
-		}
-		else assert(false);
+		std::vector<std::size_t> order(size());
+		for(std::size_t r = 0; r < order.size(); ++r)
+		 order[r] = r;
+		std::sort(order.begin(), order.end(), less);
+
+		std::vector<word_t> sorted(buf.size());
+		word_t* tar = sorted.data();
+		for(const std::size_t& r : order)
+		 tar = std::copy(rule(r), rule(r) + stride, tar);
+		buf = std::move(sorted);
 	}
 
-	void set_output(int neighbour_id, int val)
+public:
+	trans_buffer_t(unsigned n_in = 0, unsigned n_out = 0) :
+		n_in(n_in),
+		n_out(n_out),
+		in_words(words_for(n_in)),
+		out_words(words_for(n_out)),
+		stride(in_words + out_words)
 	{
-		output_vals[neighbour_id] = val;
 	}
 
-	const std::vector<int>& get_output() const { return output_vals; }
-	//! TODO: does not check for input_set!
-	const std::vector<int>& get_full_input() const { return input_vals; }
-	bool input(int neighbour_id, int* result) const {
-		bool is_set = input_set[neighbour_id];
-		if(is_set) *result = input_vals[neighbour_id];
-		return is_set;
+	std::size_t size() const { return stride ? buf.size() / stride : 0; }
+	bool empty() const { return buf.empty(); }
+	unsigned input_size() const { return n_in; }
+	unsigned output_size() const { return n_out; }
+	void reserve(std::size_t rules) { buf.reserve(rules * stride); }
+
+	//! appends a rule where all values are don't cares
+	//! @return the index of the new rule
+	std::size_t push_back() {
+		buf.resize(buf.size() + stride, 0);
+		return size() - 1;
 	}
-
-	// compares lexicographical, returns results for operator<
-	// a dontcare in front counts as a smaller value
-	friend bool _compare_by_input(const trans_t& lhs,
-		const trans_t& rhs)
+	void pop_back() { buf.resize(buf.size() - stride); }
+
+	void set_neighbour(std::size_t r, unsigned neighbour_id, int val) {
+		set_field(rule(r), neighbour_id, val); }
+	void set_output(std::size_t r, unsigned neighbour_id, int val) {
+		set_field(rule(r) + in_words, neighbour_id, val); }
+
+	//! @return false iff the input value is a don't care
+	bool input(std::size_t r, unsigned neighbour_id, int* result) const {
+		const unsigned f = get_field(rule(r), neighbour_id);
+		if(f) *result = (int)f - 1;
+		return f != 0;
+	}
+	int output(std::size_t r, unsigned neighbour_id) const {
+		return (int)get_field(rule(r) + in_words, neighbour_id) - 1; }
+
+	//! compares the whole rules @a r1 and @a r2
+	bool equal(std::size_t r1, std::size_t r2) const {
+		return std::equal(rule(r1), rule(r1) + stride, rule(r2)); }
+	bool equal_input(std::size_t r1, std::size_t r2) const {
+		return std::equal(rule(r1), rule(r1) + in_words, rule(r2)); }
+
+	//! Sorts the rules by their input and removes duplicates.
+	//! @throw if two rules have equal input, but different output
+	void sort_unique_by_input()
 	{
-		// TODO: assert same neighbour size, grid size?
-		for(unsigned i = 0; i<lhs.neighbour_size; ++i)
+		sort_by([&](std::size_t r1, std::size_t r2) {
+			return less_by_input(r1, r2); });
+		std::size_t last = 0;
+		for(std::size_t r = 1; r < size(); ++r)
+		if(!equal(last, r))
 		{
-			if(lhs.input_set[i] || rhs.input_set[i])
-			{
-				// if one of them is not set,
-				// the one which is not set is smaller
-				if(!(lhs.input_set[i]&&rhs.input_set[i]))
-				 return (int)lhs.input_set[i]
-					> (int)rhs.input_set[i];
-				else if(lhs.input_vals[i]
-					!=rhs.input_vals[i])
-				 return (lhs.input_vals[i]
-					<rhs.input_vals[i]);
-			}
+			if(equal_input(last, r))
+			 throw "Found two transitions with equal input, "
+				"but different output";
+			++last;
+			std::copy(rule(r), rule(r) + stride, rule(last));
 		}
-		return false; // if both are equal
+		buf.resize(empty() ? 0 : (last + 1) * stride);
 	}
 
-	bool operator<(const trans_t& rhs) const
+	//! sorts the rules by their output first, then by their input
+	void sort_by_output()
 	{
-		return (output_vals == rhs.output_vals)
-			? _compare_by_input(*this, rhs)
-			: (output_vals < rhs.output_vals);
+		sort_by([&](std::size_t r1, std::size_t r2) {
+			return less_by_output(r1, r2); });
 	}
 
-	bool operator==(const trans_t& rhs) const
+	void dump_rule(std::ostream& stream, std::size_t r) const
 	{
-		if(input_count != rhs.input_count)
-		 return false; // shortening
-		for(unsigned i = 0; i<neighbour_size; ++i)
-		{
-			if(input_set[i]&&rhs.input_set[i])
-			{
-				if(input_vals[i]!=rhs.input_vals[i])
-				 return false;
-			}
-			else if(input_set[i]!=input_set[i])
-			  return false; // one is not set
-		}
-		return true;
+		int val;
+		stream << "Transition function: (";
+		for(unsigned i = 0; i < n_in; ++i)
+		if(input(r, i, &val))
+		 stream << val << ' ';
+		else
+		 stream << "- ";
+		stream << ") ->";
+		for(unsigned i = 0; i < n_out; ++i)
+		 stream << output(r, i) << " ";
 	}
+};
 
-	bool operator!=(const trans_t& rhs) const
+/**
+ * @brief Transition functions compiled into a trie over their inputs.
+ *
+ * Level d of the trie decides on input value d. Each node has one child
+ * per distinct value (or don't care) of the functions below it, the
+ * don't care child first. Leaves are at level trans_buffer_t::input_size()
+ * and refer to one function.
+ */
+class trans_trie_t
+{
+public:
+	struct node_t
 	{
-		return ! operator==(rhs);
+		unsigned field; //!< 0 for don't care, v+1 for value v
+		std::size_t first; //!< first child, or function index for leaves
+		std::size_t count; //!< number of children, 0 for leaves
+	};
+private:
+	const trans_buffer_t& tf;
+	std::vector<node_t> nodes; //!< root is nodes[0], siblings are contiguous
+
+	unsigned field(std::size_t r, unsigned depth) const {
+		int val;
+		return tf.input(r, depth, &val) ? val + 1 : 0;
 	}
 
-	friend std::ostream& operator<< (std::ostream& stream,
-		const trans_t& tf) {
-		stream << "Transition function: (";
-		for( unsigned i = 0; i < tf.neighbour_size; ++i)
+	//! builds the subtree for the functions [@a first, @a last),
+	//! which are equal in their first @a depth inputs
+	void build(std::size_t parent, std::size_t first, std::size_t last,
+		unsigned depth)
+	{
+		if(depth == tf.input_size())
 		{
-			if(tf.input_set[i])
-			 stream << (tf.input_vals[i]) << ' ';
-			else
-			 stream << "- ";
+			nodes[parent].first = first; // last is first + 1
+			return;
 		}
-		stream << ") ->";
-		for(const int& i : tf.output_vals)
-		 stream << i << " ";
-		return stream;
+
+		const std::size_t first_child = nodes.size();
+		std::vector<std::size_t> bounds { first };
+		for(std::size_t r = first; r < last; )
+		{
+			const unsigned f = field(r, depth);
+			nodes.push_back(node_t { f, 0, 0 });
+			while(r < last && field(r, depth) == f)
+			 ++r;
+			bounds.push_back(r);
+		}
+		nodes[parent].first = first_child;
+		nodes[parent].count = nodes.size() - first_child;
+
+		for(std::size_t c = 0; c < nodes[parent].count; ++c)
+		 build(first_child + c, bounds[c], bounds[c + 1], depth + 1);
 	}
-};
 
-inline bool compare_by_input(const trans_t& lhs,
-		const trans_t& rhs)
-{
-	return _compare_by_input(lhs, rhs);
-}
+public:
+	//! @param tf must be sorted by input and unique,
+	//!   and must outlive this object
+	trans_trie_t(const trans_buffer_t& tf) : tf(tf)
+	{
+		nodes.push_back(node_t { 0, 0, 0 });
+		build(0, 0, tf.size(), 0);
+	}
+
+	const node_t& root() const { return nodes[0]; }
+	const node_t& child(const node_t& n, std::size_t i) const {
+		return nodes[n.first + i]; }
+	std::size_t size() const { return nodes.size(); }
+};
 
 // TODO: std::array
 template<class T>
@@ -419,6 +503,13 @@ public:
 		return std::binary_search(_n.begin(), _n.end(), p1-p2);
 	}
 
+	//! returns the position of @a p in the neighbourhood, or -1
+	int index_of(const point& p) const
+	{
+		const auto itr = std::lower_bound(_n.begin(), _n.end(), p);
+		return (itr != _n.end() && *itr == p) ? (itr - _n.begin()) : -1;
+	}
+
 /*	void shift(const point& p)
 	{
 		for(point& np : neighbours)
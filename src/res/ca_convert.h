@@ -118,7 +118,7 @@ class tv_ctor
 	const rect rect_in, rect_out;
 	const rect rect_max;
 	grid_t _in_grid;
-	std::vector<ca::trans_t> table; //!< unsorted
+	trans_buffer_t table; //!< unsorted, may contain duplicates
 
 	bool fits(const dimension& in_dim, const dimension& out_dim)
 	{
@@ -147,39 +147,32 @@ class tv_ctor
 		return new_point;
 	}
 
+	//! appends the transition function at @a p_in rotated/mirrored
+	//! by @a symm to the table
 	template<class Traits, class CellTraits>
 	void add_single_tf(
-		trans_t* tfs,
 		const point& p_in,
 		const point& p_out,
 		const _grid_t<Traits, CellTraits>& input_grid,
 		const _grid_t<Traits, CellTraits>& output_grid,
-		int symm) const
+		int symm)
 	{
-		trans_t tf(n_in.size(), n_out.size());
+		const std::size_t r = table.push_back();
 #ifdef SCA_DEBUG
 		std::cerr << "Adding rotation: " << symm << std::endl;
 #endif
 		for(unsigned i = 0; i < n_in.size(); ++i) {
 			// TODO: use center_in, center_out?
-			//tf.set_neighbour(i, input_grid[bb.coords_to_id(idx(i, symm)/*+center_cell*/)]);
+#ifdef SCA_DEBUG
 			std::cerr << idx(i, symm, n_in) << ", " << p_out << std::endl;
-			tf.set_neighbour(i, input_grid[idx(i, symm, n_in) + p_in/*- bb.ul()+center_cell*/]);
-		}
-
-		for(unsigned i = 0; i < n_out.size(); ++i) {
-
-			//tf.set_neighbour(i, input_grid[bb.coords_to_id(idx(i, symm)/*+center_cell*/)]);
-		//	std::cout << idx(i, symm, n_out) << ", " << p_out << std::endl;
-			tf.set_output(i, output_grid[idx(i, symm, n_out) + p_out/*- bb.ul()+center_cell*/]);
+#endif
+			table.set_neighbour(r, i, input_grid[idx(i, symm, n_in) + p_in/*- bb.ul()+center_cell*/]);
 		}
 
-		*tfs = tf; // TODO: redundant
+		for(unsigned i = 0; i < n_out.size(); ++i)
+		 table.set_output(r, i, output_grid[idx(i, symm, n_out) + p_out/*- bb.ul()+center_cell*/]);
 	}
 
-	//! family of 8 trans functions, subgroup of D4
-	mutable trans_t tmp_tfs[8];
-
 	bool index_ok(int idx, bool _rot, bool _mirr)
 	{
 		return (_mirr || !(idx&4)) && (_rot || !(idx&3));
@@ -194,28 +187,21 @@ class tv_ctor
 		bool _rot,
 		bool _mirr)
 	{
-		// family of 8 trans functions, subgroup of D4
-	//	assert(bb.x_size() == input_grid.dim().width());
-	//	assert(bb.y_size() == input_grid.dim().height());
-
-		// TODO: unroll?
-		int used = 0;
+		// family of up to 8 trans functions, subgroup of D4
+		// symmetric neighbourhoods often give equal functions,
+		// so remove them already here (the rest is done on sorting)
+		const std::size_t first = table.size();
 		for(int i = 0; i < 8; ++i)
 		if(index_ok(i, _rot, _mirr))
 		{
-			++used;
-			add_single_tf(tmp_tfs + i, p_in, p_out, input_grid, output_grid, i);
-		}
-
-
-		std::sort(tmp_tfs, tmp_tfs + used);
-		for(int i = 0; i < used; ++i)
-		if((i==0) || (tmp_tfs[i-1] != tmp_tfs[i]))
-		{
-#ifdef SCA_DEBUG
-			std::cerr << "pushing back: " << tmp_tfs[i] << std::endl;
-#endif
-			table.push_back(tmp_tfs[i]);
+			add_single_tf(p_in, p_out, input_grid, output_grid, i);
+			const std::size_t added = table.size() - 1;
+			for(std::size_t r = first; r < added; ++r)
+			if(table.equal(r, added))
+			{
+				table.pop_back();
+				break;
+			}
 		}
 	}
 
@@ -230,16 +216,7 @@ public:
 		rect_out(n_out.get_rect()),
 		rect_max(rect_cover(rect_in, rect_out)),
 		_in_grid(n_dim, 0),
-		tmp_tfs {
-			trans_t(n_in.size(), n_out.size()),
-			trans_t(n_in.size(), n_out.size()),
-			trans_t(n_in.size(), n_out.size()),
-			trans_t(n_in.size(), n_out.size()),
-			trans_t(n_in.size(), n_out.size()),
-			trans_t(n_in.size(), n_out.size()),
-			trans_t(n_in.size(), n_out.size()),
-			trans_t(n_in.size(), n_out.size()),
-		}
+		table(n_in.size(), n_out.size())
 	{
 #ifdef SCA_DEBUG
 		std::cerr << "N in: " << n_in << std::endl;
@@ -301,25 +278,14 @@ public:
 class trans_vector_t
 {
 	ca::n_t n_in, n_out;
-	using table_v = std::vector<ca::trans_t>;
-	table_v table; //!< sorted by input (first)
+	trans_buffer_t table; //!< sorted by input, unique
 
-	static table_v get_table_from_cons(table_v&& _tbl)
+	static trans_buffer_t get_table_from_cons(trans_buffer_t&& _tbl)
 	{
-		assert(_tbl.size() > 0);
-
-		// uniq assertion
-		std::sort(_tbl.begin(), _tbl.end(), ca::compare_by_input);
-		const ca::trans_t* recent = &(_tbl[0]);
-
-		for(table_v::const_iterator itr
-			= (++_tbl.begin()); itr != _tbl.end(); ++itr)
-		{
-			assert(*itr != *recent);
-			recent = &*itr;
-		}
-
-		return _tbl;
+		if(_tbl.empty())
+		 throw "No transition functions given.";
+		_tbl.sort_unique_by_input();
+		return std::move(_tbl);
 	}
 
 public:
@@ -378,31 +344,31 @@ public:
 	void dump_as_formula_at(std::ostream& stream, int output_idx) const
 	{
 		// write to out // TODO: redundant?
-		std::vector<ca::trans_t> table_copy = table;
-		std::sort(table_copy.begin(), table_copy.end()); // compares only by output
+		trans_buffer_t table_copy = table;
+		table_copy.sort_by_output();
 
 		{
 			std::size_t braces = 0;
 
-			int recent_output = table_copy[0].get_output()[output_idx];
+			int recent_output = table_copy.output(0, output_idx);
 			stream << "(" << std::endl;
 			// print functions
-			for(const auto& tf : table_copy)
+			for(std::size_t r = 0; r < table_copy.size(); ++r)
 			{
-				if(recent_output != tf.get_output()[output_idx])
+				if(recent_output != table_copy.output(r, output_idx))
 				{
 					//printf("0 ) ? %d : (\n"
 					//"(\n", recent_output);
 					stream << "0 ) ? " << recent_output
 						<< " : (\n(\n";
 					++braces;
-					recent_output = tf.get_output()[output_idx];
+					recent_output = table_copy.output(r, output_idx);
 				}
 
 				for(unsigned i = 0; i < n_in.size(); i++)
 				{
 					int input_val;
-					const bool is_set = tf.input(i, &input_val);
+					const bool is_set = table_copy.input(r, i, &input_val);
 					assert(is_set);
 					if(is_set)
 						stream << "(h[" << i << "] == " << input_val
@@ -23,6 +23,7 @@
 
 #include <map>
 #include <stack>
+#include <vector>
 #if 0
 #include <boost/graph/graph_traits.hpp>
 #include <boost/graph/adjacency_list.hpp>
@@ -40,8 +41,8 @@ class eqsolver_t // TODO: can we move the private members to inheriting class?
 {
 private:
 	eqsolver::expression_ast ast;
-	int* helper_vars = nullptr; //!< @todo: auto/unique_ptr
-	std::size_t helpers_size;
+	//! mutable, since the formula writes them while being evaluated
+	mutable std::vector<int> helper_vars;
 	std::size_t _num_states;
 //	n_t_const neighbourhood;
 
@@ -60,8 +61,18 @@ private:
 
 
 public:
+	//! evaluating writes helper_vars, so threads need their own copy
+	static constexpr bool concurrent_next_state = false;
+
 	std::size_t num_states() const noexcept { return _num_states; }
 
+	//! whether the formula reads the variables x or y, i.e. whether
+	//!   the next state can depend on the cell's position
+	bool uses_position() const
+	{
+		return eqsolver::ast_area<eqsolver::variable_area_position>()(ast);
+	}
+
 	template<class Traits>
 	typename Traits::u_coord_t calc_border_width() const
 	{
@@ -88,8 +99,6 @@ public:
 		return unite(calc_n_in<Traits>(), calc_n_out<Traits>());
 	}
 
-	~eqsolver_t() noexcept { delete[] helper_vars; }
-
 	// TODO: single funcs to initialize and make const?
 	// aka: : ast(private_build_ast), ...
 	eqsolver_t(const char* equation, unsigned num_states = 0) // TODO: cpp file
@@ -109,13 +118,11 @@ public:
 #endif
 		eqsolver::ast_area<eqsolver::variable_area_helpers>
 				helpers_solver;
-		helpers_size = (int)helpers_solver(ast) + 1;
+		helper_vars.resize((int)helpers_solver(ast) + 1);
 #ifdef CA_DEBUG
 		printf("Size of Helper Variable Array: %d\n",
-		       helpers_size);
+		       (int)helper_vars.size());
 #endif
-		if(helpers_size > 0)
-			helper_vars = new int[helpers_size];
 
 #if 0
 		eqsolver::ast_minmax minmax_solver(helpers_size);
@@ -145,11 +152,36 @@ public:
 		using vprinter_t = eqsolver::_variable_print<Src, Tar>;
 		vprinter_t vprinter(
 			p.x, p.y,
-			src_array, tar_array, helper_vars);
+			src_array, tar_array, helper_vars.data());
 		eqsolver::ast_print<vprinter_t> solver(&vprinter);
 		return (int)solver(ast);
 	}
 
+	//! Like calculate_next_state_old, but for the @a n cells
+	//! starting at @a p and going right. The visitors are only
+	//! built once for all cells.
+	//! @param res array of at least @a n elements for the results
+	template<class T, class CT>
+	void calculate_next_states_line(const typename CT::cell_t *cell_ptr,
+		const _point<T>& p, std::size_t n, const _dimension<T>& dim,
+		int* res) const
+	{
+		using src_t = eqsolver::const_grid_storage_array;
+		using vprinter_t = eqsolver::_variable_print<
+			src_t, eqsolver::grid_storage_single>;
+		int result;
+		vprinter_t vprinter(p.x, p.y, src_t(cell_ptr, dim.width()),
+			eqsolver::grid_storage_single(&result),
+			helper_vars.data());
+		eqsolver::ast_print<vprinter_t> solver(&vprinter);
+		for(std::size_t i = 0; i < n; ++i)
+		{
+			vprinter.move_to(p.x + i, p.y,
+				src_t(cell_ptr + i, dim.width()));
+			res[i] = (int)solver(ast);
+		}
+	}
+
 	template<class T, class CT>
 	int calculate_next_state_old(const typename CT::cell_t *cell_ptr,
 		const _point<T>& p, const _dimension<T>& dim) const
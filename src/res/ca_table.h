@@ -25,6 +25,8 @@
 #include "ca_eqs.h"
 #include "bitgrid.h"
 
+#include <algorithm>
+#include <thread>
 #include <vector>
 
 namespace sca { namespace ca {
@@ -190,6 +192,10 @@ public:
 	}
 
 	std::size_t num_states() const noexcept { return own_num_states; }
+	//! looking up the table only reads it
+	static constexpr bool concurrent_next_state = true;
+	//! tables only map neighbourhoods to next states
+	bool uses_position() const noexcept { return false; }
 };
 
 class _table_t : public _table_hdr_t // TODO: only for reading?
@@ -250,77 +256,6 @@ private:
 
 	};
 
-	class from_trans
-	{
-		const std::vector<trans_t>& tf;
-		mutable std::vector<trans_t>::const_iterator itr;
-		const u_coord_t size_each;
-		const n_t _n_in, _n_out;
-		const point center, center_out;
-
-		template<class Grid, class Conf>
-		bool grid_has_conf(const Grid& g, const Conf& c) const
-		{
-			conf_t::const_iterator citr = c.cbegin();
-			const auto cb = [&](const _point<bitgrid_traits>& p) {
-				return ((int)g[p]) == *(citr++);
-			};
-			return _n_in.for_each_bool(center, cb);
-		}
-	public:
-		from_trans(const std::vector<trans_t>& tf, u_coord_t size_each, const n_t& _n_in, const n_t& _n_out, const point& center) :
-			tf(tf),
-			itr(tf.cbegin()),
-			size_each(size_each),
-			_n_in(_n_in),
-			_n_out(_n_out),
-			center(center),
-			center_out(_n_out.center())
-		{}
-
-		uint64_t operator()(const bitgrid_t& grid) const
-		{
-			// TODO!! thread safety!
-			//static dimension n_out_dim = _n_out.get_dim();
-
-			bitgrid_t bit_tmp_result(size_each, dimension(_n_out.size(), 1), 0, 0);
-
-			if(itr != tf.cend() &&
-				grid_has_conf(grid, itr->get_full_input()))
-			{
-#ifdef TABLE_DEBUG
-				std::cerr << "equal:" << grid << ", " << *itr << std::endl;
-#endif
-				for(std::size_t i = 0; i < _n_out.size(); ++i)
-				 bit_tmp_result[point(i, 0)] = itr->get_output()[i];
-
-				for(std::size_t i = 0; i < _n_out.size(); ++i)
-				 bit_tmp_result[point(i, 0)] = itr->get_output()[i];
-			//	 bit_tmp_result[center_out + p] = itr->get_output()[p.id()];
-
-				++itr;
-			}
-			else
-			{
-#ifdef TABLE_DEBUG
-				if(itr == tf.cend())
-				 std::cerr << "differ:" << grid << ", " << "(end)" << std::endl;
-				else
-				 std::cerr << "differ:" << grid << ", " << *itr << std::endl;
-#endif
-
-				for(const auto& p : ca::counted(_n_out))
-				 bit_tmp_result[point(p.id(), 0)] = grid[center + p];
-			//	 bit_tmp_result[center_out + p] = grid[center + p];
-			}
-
-			//std::cerr << grid << "->" << bit_tmp_result << std::endl;
-
-			return bit_tmp_result.raw_value();
-		}
-
-	};
-
 	// TODO : static?
 	//! used to dump an in-memory-table from an equation
 	template<class Functor>
@@ -394,14 +329,119 @@ private:
 				size_each, _n_out, center));
 	}
 
-	//! used to dump an in-memory-table from a vector of transitions
-	std::vector<uint64_t> calculate_table_trans(const std::vector<trans_t>& tf) const
+	//! writes the identity for inputs [@a depth, n_in) into @a tbl,
+	//! i.e. the output cells keep their values
+	//! @param keep_factor see calculate_table_trans
+	void fill_identity(std::vector<uint64_t>& tbl,
+		const std::vector<uint64_t>& keep_factor,
+		unsigned depth, uint64_t idx, uint64_t out) const
 	{
-		return calculate_table(
-			from_trans(tf,
-				size_each, _n_in, _n_out, center));
+		const unsigned shift = depth * size_each;
+		if(depth + 1 == _n_in.size())
+		{ // strided write of the last level
+			for(uint64_t v = 0; v < own_num_states; ++v)
+			 tbl[idx | (v << shift)] = out + v * keep_factor[depth];
+		}
+		else for(uint64_t v = 0; v < own_num_states; ++v)
+		 fill_identity(tbl, keep_factor, depth + 1, idx | (v << shift),
+			out + v * keep_factor[depth]);
+	}
+
+	//! writes the functions of the subtree @a n into @a tbl
+	//! don't cares are expanded to all states
+	void fill_trie(std::vector<uint64_t>& tbl, const trans_trie_t& trie,
+		const std::vector<uint64_t>& outputs,
+		const trans_trie_t::node_t& n, unsigned depth, uint64_t idx) const
+	{
+		if(!n.count)
+		{
+			tbl[idx] = outputs[n.first];
+			return;
+		}
+		const unsigned shift = depth * size_each;
+		for(std::size_t c = 0; c < n.count; ++c)
+		{
+			const trans_trie_t::node_t& ch = trie.child(n, c);
+			if(ch.field)
+			 fill_trie(tbl, trie, outputs, ch, depth + 1,
+				idx | ((uint64_t)(ch.field - 1) << shift));
+			else for(uint64_t v = 0; v < own_num_states; ++v)
+			 fill_trie(tbl, trie, outputs, ch, depth + 1,
+				idx | (v << shift));
+		}
 	}
 
+	/**
+	 * @brief Used to dump an in-memory-table from a vector of transitions.
+	 *
+	 * The functions are compiled into a trie, which is walked to fill
+	 * the table. Inputs with no function keep the values of their output
+	 * cells. If multiple functions match an input, the first one in the
+	 * sorting order wins, i.e. the one which is not a don't care at the
+	 * first differing input.
+	 *
+	 * The table is split on the values of the first input cell, each part
+	 * is filled by one thread.
+	 *
+	 * @param tf sorted by input and unique
+	 */
+	std::vector<uint64_t> calculate_table_trans(const trans_buffer_t& tf,
+		unsigned n_threads = 0) const
+	{
+		std::vector<uint64_t> tbl((uint64_t)1 << (size_each * _n_in.size()),
+			entry_invalid());
+		if(_n_in.size() == 0)
+		 return tbl;
+
+		// keep_factor[i] * v is the output if n_in[i] has value v
+		// and no function matches
+		std::vector<uint64_t> keep_factor(_n_in.size(), 0);
+		for(std::size_t o = 0; o < _n_out.size(); ++o)
+		for(std::size_t i = 0; i < _n_in.size(); ++i)
+		if(_n_in[i] == _n_out[o])
+		 keep_factor[i] = (uint64_t)1 << (o * size_each);
+
+		std::vector<uint64_t> outputs(tf.size(), 0);
+		for(std::size_t r = 0; r < tf.size(); ++r)
+		for(std::size_t o = 0; o < _n_out.size(); ++o)
+		 outputs[r] |= (uint64_t)tf.output(r, o) << (o * size_each);
+
+		const trans_trie_t trie(tf);
+
+		// all entries where the first input has value v0
+		const auto fill_part = [&](uint64_t v0)
+		{
+			if(_n_in.size() == 1)
+			 tbl[v0] = v0 * keep_factor[0];
+			else
+			 fill_identity(tbl, keep_factor, 1, v0, v0 * keep_factor[0]);
+
+			const trans_trie_t::node_t& root = trie.root();
+			for(std::size_t c = 0; c < root.count; ++c)
+			{
+				const trans_trie_t::node_t& ch = trie.child(root, c);
+				if(!ch.field || ch.field - 1 == v0)
+				 fill_trie(tbl, trie, outputs, ch, 1, v0);
+			}
+		};
+
+		if(!n_threads)
+		 n_threads = std::max(1u, std::thread::hardware_concurrency());
+		n_threads = std::min(n_threads, own_num_states);
+
+		std::vector<std::thread> threads;
+		for(unsigned t = 1; t < n_threads; ++t)
+		 threads.emplace_back([&, t]() {
+			for(uint64_t v0 = t; v0 < own_num_states; v0 += n_threads)
+			 fill_part(v0);
+		});
+		for(uint64_t v0 = 0; v0 < own_num_states; v0 += n_threads)
+		 fill_part(v0);
+		for(std::thread& th : threads)
+		 th.join();
+
+		return tbl;
+	}
 
 	uint32_t states_dead_from_table()
 	{
@@ -500,7 +540,7 @@ public:
 		set_dead_states(states_dead_from_table());
 	}
 
-	_table_t(const std::vector<trans_t>& tf,
+	_table_t(const trans_buffer_t& tf,
 		cell_t num_states,
 		const n_t& n_in,
 		const n_t& n_out) :
@@ -684,6 +724,38 @@ public:
 	}
 
 
+	//! packs the states around @a cell_ptr into a table index,
+	//!   with the cells in the order of n_in
+	//! @return false iff a state is out of range (e.g. on the border)
+	template<class T, class GCT>
+	bool neighbourhood_key(const typename GCT::cell_t *cell_ptr,
+		const _dimension<T>& dim, uint64_t& key) const
+	{
+		key = 0;
+		u_coord_t shift = 0;
+		for(const point& p2 : _n_in)
+		{
+			const auto c = cell_ptr[(coord_t)(p2.y * (coord_t)dim.width() + p2.x)];
+			if(c < 0 || c >= (int)own_num_states)
+			 return false;
+			key |= (uint64_t)c << shift;
+			shift += size_each;
+		}
+		return true;
+	}
+
+	//! next state (bitgrid's raw value) for a key from neighbourhood_key
+	uint64_t next_state_of_key(uint64_t key) const { return table[key]; }
+
+	//! returns @a key with the state of the @a idx'th cell of n_in
+	//!   replaced by @a state
+	uint64_t replace_in_key(uint64_t key, unsigned idx, uint64_t state) const
+	{
+		const u_coord_t shift = idx * size_each;
+		const uint64_t mask = ((uint64_t)1 << size_each) - 1;
+		return (key & ~(mask << shift)) | (state << shift);
+	}
+
 	//! version for multi-targets
 	template<class T, class GCT>
 	bool calculate_next_state(const typename GCT::cell_t *cell_ptr,
@@ -0,0 +1,79 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+//! @file cycle.h detection of cycles in sequences, e.g. of grid hashes
+
+#ifndef CYCLE_H
+#define CYCLE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sca {
+
+/**
+ * @brief Brent's cycle detection for a sequence which is fed value by value.
+ *
+ * Only one value of the sequence is stored. If the sequence becomes
+ * periodic with period p after a transient of length t, the cycle is
+ * found after at most 2 * max(t, p) + p values.
+ *
+ * The transient length can be found afterwards by running the sequence
+ * twice from the start, with an offset of period() values, until the
+ * values are equal.
+ */
+class brent_detector_t
+{
+	uint64_t tortoise = 0;
+	std::size_t power = 1, lam = 0;
+	bool started = false, found = false;
+public:
+	//! feeds the next value
+	//! @return true iff a cycle has been found (now or before)
+	bool feed(uint64_t x)
+	{
+		if(found)
+		 return true;
+		if(!started)
+		{
+			tortoise = x;
+			started = true;
+			return false;
+		}
+		++lam;
+		if(x == tortoise)
+		 return found = true;
+		if(lam == power)
+		{
+			tortoise = x;
+			power <<= 1;
+			lam = 0;
+		}
+		return false;
+	}
+
+	bool cycle_found() const { return found; }
+	//! the period, if a cycle has been found
+	std::size_t period() const { return lam; }
+};
+
+}
+
+#endif // CYCLE_H
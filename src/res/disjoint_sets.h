@@ -24,6 +24,7 @@
 #include <vector>
 #include <map>
 #include <stack>
+#include <limits>
 
 #include <boost/pending/disjoint_sets.hpp>
 
@@ -117,29 +118,57 @@ std::vector<std::vector<typename Cont::value_type>> get_scc_areas_v_all(
 	return get_scc_areas_v(tmp, _area, n2);
 }
 
+/**
+ * Finds connected components of an area on a grid.
+ *
+ * Components are labeled with ids that keep growing over several calls
+ * ("epochs"): a cell belongs to the current call iff its label is greater
+ * than the label base of this call. This way, the visited grid only needs
+ * to be cleared if the ids would overflow, and each call costs
+ * O(area * n) instead of O(grid).
+ */
 template<class Grid>
 class grid_scc_finder_t
 {
-	mutable Grid _visited_grid;
 	using point = typename Grid::point;
+	using cell_t = typename Grid::value_type;
+
+	mutable Grid _visited_grid;
+	//! all labels <= this belong to previous calls
+	mutable cell_t _id_base = 0;
+	//! highest label used so far
+	mutable cell_t _id_top = 0;
+	//! dfs stack, kept to avoid reallocations
+	mutable std::vector<point> _stack;
+
+	bool visited(const point& p) const { return _visited_grid[p] > _id_base; }
 
-	// TODO: non recursive
-	//! grid dfs for the one component starting at p
+	//! grid dfs for the one component starting at @a start
 	//! complexity: O(n + T_abort)
 	template<class NClass, class Functor>
 	void grid_dfs(
-		const typename Grid::point& p,
+		const point& start,
 		const NClass& n,
 		const Functor& cb_abort,
-		std::size_t id) const
+		cell_t id) const
 	{
-		_visited_grid[p] = id;
-		for(const point& np : n)
+		_visited_grid[start] = id;
+		_stack.push_back(start);
+		while(!_stack.empty())
 		{
-			const point next = p + np;
-			if(_visited_grid.contains(next) // be careful
-				&& (!_visited_grid[next]) && !cb_abort(p, next))
-			 grid_dfs(next, n, cb_abort, id);
+			const point p = _stack.back();
+			_stack.pop_back();
+			for(const point& np : n)
+			{
+				const point next = p + np;
+				if(_visited_grid.contains(next) // be careful
+					&& !visited(next) && !cb_abort(p, next))
+				{
+					// mark on push, so each cell is pushed only once
+					_visited_grid[next] = id;
+					_stack.push_back(next);
+				}
+			}
 		}
 	}
 
@@ -151,15 +180,23 @@ class grid_scc_finder_t
 		const Cont& area,
 		const Functor& cb_abort) const
 	{
-		_visited_grid.reset(0);
+		// there are at most area.size() new ids
+		_id_base = _id_top;
+		if((std::size_t)(std::numeric_limits<cell_t>::max() - _id_base)
+			<= area.size())
+		{
+			_visited_grid.reset(0);
+			_id_base = 0;
+		}
 
 		// each point of area is only visited once
 		// -> complexity O(area * (n + abort))
 		std::size_t last_id = 0;
 		for(const point& p : area)
-		if((!_visited_grid[p]) /*&& !cb_abort(p)*/) // abort is not called for points in area
-		 grid_dfs(p, n, cb_abort, ++last_id);
+		if(!visited(p)) // abort is not called for points in area
+		 grid_dfs(p, n, cb_abort, _id_base + (cell_t)(++last_id));
 
+		_id_top = _id_base + (cell_t)last_id;
 		return last_id;
 	}
 
@@ -182,7 +219,7 @@ public:
 		cb_size(num);
 		for(const point& p : ini_area)
 		{
-			const auto& comp_id = _visited_grid[p];
+			const cell_t comp_id = component_id(p);
 			assert(comp_id != 0);
 			cb_action(p, comp_id - 1);
 		}
@@ -224,8 +261,16 @@ public:
 	{
 		// TODO: version with borders?
 		_visited_grid = Grid(human_dim, 0, 0);
+		_id_base = _id_top = 0;
 	}
 
+	//! returns the component id (starting at 1) that the last call
+	//! assigned to @a p, or a value <= 0 if @a p was not visited
+	cell_t component_id(const point& p) const {
+		return _visited_grid[p] - _id_base; }
+
+	//! @note ids in here are shifted by the ids of previous calls,
+	//!   use @a component_id for the ids of the last call
 	const Grid& visited_grid() const { return _visited_grid; }
 
 /*	//! complexity: O(area * (n + abort))
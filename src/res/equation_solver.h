@@ -27,6 +27,7 @@
 #include <tuple>
 #include <algorithm>
 #include <limits>
+#include <vector>
 
 //#include <boost/spirit/include/support_info.hpp>
 //#include <boost/phoenix/bind/bind_function.hpp>
@@ -171,7 +172,7 @@ protected:
 class const_grid_storage_array : grid_storage_base
 {
 	using storage_t = const int*;
-	storage_t const v;
+	storage_t v; // not const, so the storage can be moved along a line
 public:
 	const_grid_storage_array(storage_t const v, int width) :
 		grid_storage_base(width), v(v) {}
@@ -268,6 +269,12 @@ private:
 	GridStorageTar tar;
 	int* helper_vars;
 public:
+	//! moves the visitor to another cell, keeping all other state
+	void move_to(int _x, int _y, const GridStorageSrc& _src) {
+		x = _x; y = _y; src = _src; }
+	//! sets x, e.g. for evaluating formulas in x only
+	void move_to(int _x) { x = _x; }
+
 	inline unsigned int operator()(nil) const { return 0; }
 	inline result_type operator()(vaddr::var_x) const { return x; }
 	inline result_type operator()(vaddr::var_y) const { return y; }
@@ -325,6 +332,18 @@ struct variable_area_cont : public boost::static_visitor<Cont>
 };
 
 
+//! 1 for the variables x and y, 0 otherwise
+struct variable_area_position : public boost::static_visitor<visit_result_type>
+{
+	inline unsigned int operator()(nil) const { return 0; }
+	inline unsigned int operator()(vaddr::var_x) const { return 1; }
+	inline unsigned int operator()(vaddr::var_y) const { return 1; }
+	template<bool Addr>
+	inline unsigned int operator()(vaddr::var_array<Addr> ) const { return 0; }
+	template<bool T>
+	inline unsigned int operator()(vaddr::var_helper<T> ) const { return 0; }
+};
+
 struct variable_area_helpers : public boost::static_visitor<visit_result_type>
 {
 	inline int operator()(nil) const { return -1; }
@@ -1123,6 +1142,46 @@ public:
 
 #endif
 
+/**
+	Evaluates an expression in x for whole blocks of values.
+	The visitors and the helper variables are only built once,
+	so this is much faster than building an ast_print for each value.
+*/
+class batch_evaluator
+{
+	const expression_ast& ast;
+	std::vector<int> helper_vars;
+	variable_print vprinter;
+	ast_print<variable_print> solver;
+public:
+	//! @param ast must outlive this object
+	batch_evaluator(const expression_ast& ast) :
+		ast(ast),
+		helper_vars((int)ast_area<variable_area_helpers>()(ast) + 1),
+		vprinter(0, 0, grid_storage_nothing(), grid_storage_nothing(),
+			helper_vars.data()),
+		solver(&vprinter)
+	{
+	}
+
+	//! evaluates the expression for one value of x
+	int operator()(int x) {
+		vprinter.move_to(x);
+		return (int)solver(ast);
+	}
+
+	//! evaluates the expression for x = @a in[0], ..., @a in[n-1]
+	//! and writes the results to @a out, which may equal @a in
+	void operator()(const int* in, std::size_t n, int* out)
+	{
+		for(std::size_t i = 0; i < n; ++i)
+		{
+			vprinter.move_to(in[i]);
+			out[i] = (int)solver(ast);
+		}
+	}
+};
+
 const char* get_help_description();
 
 /**
@@ -366,14 +366,7 @@ public:
 		base(dim, border_width),
 		_data(base::storage_area(), fill) // TODO: segfaults if area = 0
 	{
-		u_coord_t linewidth = dim.width(),
-			storage_lw = linewidth + bw_2;
-		area_t top = bw * (storage_lw - 1);
-		std::fill_n(_data.begin(), top, border_fill);
-		for(std::size_t i = top; i < _data.size() - top; i += storage_lw)
-			std::fill_n(_data.begin() + i, bw_2, border_fill);
-		std::fill(_data.end() - top, _data.end(), border_fill);
-	//	data.assign(data.begin(), data.begin() + top, border_fill);
+		reset_border(border_fill);
 	}
 
 	//! borderless version
@@ -401,6 +394,10 @@ public:
 		write_grid(fp, &tmp, &_dim, bw);
 	}
 
+	_grid_t(const _grid_t& ) = default;
+	//! moves the data, e.g. for passing grids between pipeline stages
+	_grid_t(_grid_t&& ) = default;
+
 	_grid_t& operator=(const _grid_t& rhs)
 	{
 		base::operator=(rhs);
@@ -408,6 +405,27 @@ public:
 		return *this;
 	}
 
+	_grid_t& operator=(_grid_t&& rhs)
+	{
+		base::operator=(rhs);
+		_data = std::move(rhs._data);
+		return *this;
+	}
+
+	//! sets all border cells to @a border_fill, e.g. after algorithms
+	//!   which modify the border
+	void reset_border(const cell_t& border_fill =
+		std::numeric_limits<cell_t>::min())
+	{
+		const u_coord_t storage_lw = _dim.dx();
+		area_t top = bw * (storage_lw - 1);
+		std::fill_n(_data.begin(), top, border_fill);
+		for(std::size_t i = top; i < _data.size() - top; i += storage_lw)
+			std::fill_n(_data.begin() + i, bw_2, border_fill);
+		std::fill(_data.end() - top, _data.end(), border_fill);
+	//	data.assign(data.begin(), data.begin() + top, border_fill);
+	}
+
 	//!< resets everything except the border to new_value
 	//!< @todo not tested yet
 	void reset(const cell_t& new_value)
@@ -0,0 +1,282 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+//! @file grid_algebra.h element-wise arithmetic on grids
+
+#ifndef GRID_ALGEBRA_H
+#define GRID_ALGEBRA_H
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "grid.h"
+
+/**
+ * All kernels only touch the human cells, i.e. skip the border. They
+ * iterate over rows, with an inner loop over plain arrays that the
+ * compiler can vectorize. Large grids are split into blocks of rows,
+ * one per thread.
+ *
+ * The right hand side of binary operations can either be a grid of the
+ * same human dimension or a scalar, which is broadcast to all cells.
+ */
+namespace grid_algebra
+{
+
+/*
+ * operators
+ */
+struct add_op { template<class T> T operator()(T a, T b) const { return a + b; } };
+struct sub_op { template<class T> T operator()(T a, T b) const { return a - b; } };
+struct mul_op { template<class T> T operator()(T a, T b) const { return a * b; } };
+struct min_op { template<class T> T operator()(T a, T b) const { return std::min(a, b); } };
+struct max_op { template<class T> T operator()(T a, T b) const { return std::max(a, b); } };
+struct eq_op { template<class T> T operator()(T a, T b) const { return a == b; } };
+struct ne_op { template<class T> T operator()(T a, T b) const { return a != b; } };
+struct lt_op { template<class T> T operator()(T a, T b) const { return a < b; } };
+struct le_op { template<class T> T operator()(T a, T b) const { return a <= b; } };
+struct gt_op { template<class T> T operator()(T a, T b) const { return a > b; } };
+struct ge_op { template<class T> T operator()(T a, T b) const { return a >= b; } };
+
+namespace detail
+{
+
+//! grids with less cells are never split among threads
+constexpr std::size_t parallel_min_area = 1 << 20;
+
+//! number of row blocks for @a grid, @a n_threads = 0 means automatic
+template<class Grid>
+unsigned num_blocks(const Grid& grid, unsigned n_threads)
+{
+	const unsigned rows = grid.human_dim().dy();
+	if(!n_threads)
+	 n_threads = (grid.human_dim().area() < parallel_min_area)
+		? 1 : std::max(1u, std::thread::hardware_concurrency());
+	return std::max(1u, std::min(n_threads, rows));
+}
+
+//! calls @a ftor(block, y0, y1) for @a n_blocks blocks of rows, in parallel
+template<class Grid, class Functor>
+void for_blocks(const Grid& grid, unsigned n_blocks, const Functor& ftor)
+{
+	using coord_t = typename Grid::traits_t::coord_t;
+	const coord_t rows = grid.human_dim().dy();
+	const coord_t per_block = (rows + n_blocks - 1) / n_blocks;
+	const auto run = [&](unsigned block) {
+		const coord_t y0 = std::min(rows, (coord_t)(block * per_block));
+		ftor(block, y0, std::min(rows, (coord_t)(y0 + per_block)));
+	};
+
+	std::vector<std::thread> threads;
+	for(unsigned block = 1; block < n_blocks; ++block)
+	 threads.emplace_back(run, block);
+	run(0);
+	for(std::thread& t : threads)
+	 t.join();
+}
+
+template<class Grid>
+void assert_same_dim(const Grid& lhs, const Grid& rhs)
+{
+	if(lhs.human_dim() != rhs.human_dim())
+	 throw "Different dimensions in both grids are not allowed.";
+}
+
+//! row kernels, @a len cells starting at @a a (and @a b)
+template<class T, class Op>
+void row(T* __restrict a, const T* __restrict b, std::size_t len,
+	const Op& op)
+{
+	for(std::size_t i = 0; i < len; ++i)
+	 a[i] = op(a[i], b[i]);
+}
+
+template<class T, class Op>
+void row(T* __restrict a, const T b, std::size_t len, const Op& op)
+{
+	for(std::size_t i = 0; i < len; ++i)
+	 a[i] = op(a[i], b);
+}
+
+}
+
+/*
+ * transformations
+ */
+//! sets each cell of @a lhs to @a op(lhs, rhs)
+template<class Grid, class Op>
+void transform(Grid& lhs, const Grid& rhs, const Op& op,
+	unsigned n_threads = 0)
+{
+	using point = typename Grid::point;
+	detail::assert_same_dim(lhs, rhs);
+	const std::size_t len = lhs.human_dim().dx();
+	if(!len)
+	 return;
+	detail::for_blocks(lhs, detail::num_blocks(lhs, n_threads),
+		[&](unsigned , int y0, int y1) {
+		for(int y = y0; y < y1; ++y)
+		 detail::row(&lhs[point(0, y)], &rhs[point(0, y)], len, op);
+	});
+}
+
+//! sets each cell of @a lhs to @a op(lhs, value)
+template<class Grid, class Op>
+void transform(Grid& lhs, const typename Grid::cell_traits_t::cell_t& value,
+	const Op& op, unsigned n_threads = 0)
+{
+	using point = typename Grid::point;
+	const std::size_t len = lhs.human_dim().dx();
+	if(!len)
+	 return;
+	detail::for_blocks(lhs, detail::num_blocks(lhs, n_threads),
+		[&](unsigned , int y0, int y1) {
+		for(int y = y0; y < y1; ++y)
+		 detail::row(&lhs[point(0, y)], value, len, op);
+	});
+}
+
+template<class Grid, class Rhs>
+void add(Grid& lhs, const Rhs& rhs, unsigned n_threads = 0) {
+	transform(lhs, rhs, add_op(), n_threads); }
+template<class Grid, class Rhs>
+void sub(Grid& lhs, const Rhs& rhs, unsigned n_threads = 0) {
+	transform(lhs, rhs, sub_op(), n_threads); }
+template<class Grid, class Rhs>
+void mul(Grid& lhs, const Rhs& rhs, unsigned n_threads = 0) {
+	transform(lhs, rhs, mul_op(), n_threads); }
+template<class Grid, class Rhs>
+void min(Grid& lhs, const Rhs& rhs, unsigned n_threads = 0) {
+	transform(lhs, rhs, min_op(), n_threads); }
+template<class Grid, class Rhs>
+void max(Grid& lhs, const Rhs& rhs, unsigned n_threads = 0) {
+	transform(lhs, rhs, max_op(), n_threads); }
+
+//! restricts all cells of @a grid to [@a lo, @a hi]
+template<class Grid>
+void clamp(Grid& grid, const typename Grid::cell_traits_t::cell_t& lo,
+	const typename Grid::cell_traits_t::cell_t& hi, unsigned n_threads = 0)
+{
+	max(grid, lo, n_threads);
+	min(grid, hi, n_threads);
+}
+
+//! sets each cell of @a lhs to 1 if @a op(lhs, rhs) holds, and 0 otherwise
+//! @param op a comparison, e.g. eq_op or lt_op
+template<class Grid, class Rhs, class Op>
+void compare(Grid& lhs, const Rhs& rhs, const Op& op, unsigned n_threads = 0) {
+	transform(lhs, rhs, op, n_threads); }
+
+/*
+ * reductions
+ */
+namespace detail
+{
+
+//! folds the rows of @a grid into one value per block, using
+//!   @a fold(res, row_ptr, len), and combines the blocks using @a combine
+template<class T, class Grid, class Fold, class Combine>
+T reduce_rows(const Grid& grid, T init, const Fold& fold,
+	const Combine& combine, unsigned n_threads)
+{
+	using point = typename Grid::point;
+	const std::size_t len = grid.human_dim().dx();
+	if(!len)
+	 return init;
+	const unsigned n_blocks = num_blocks(grid, n_threads);
+	std::vector<T> partial(n_blocks, init);
+	for_blocks(grid, n_blocks, [&](unsigned block, int y0, int y1) {
+		T res = init;
+		for(int y = y0; y < y1; ++y)
+		 res = fold(res, &grid[point(0, y)], len);
+		partial[block] = res;
+	});
+	return std::accumulate(partial.begin(), partial.end(), init, combine);
+}
+
+}
+
+//! folds all cells of @a grid with @a op, starting with @a init
+//! @param init must be neutral for @a op, since each thread starts with it
+template<class T, class Grid, class Op>
+T reduce(const Grid& grid, T init, const Op& op, unsigned n_threads = 0)
+{
+	using cell_t = typename Grid::cell_traits_t::cell_t;
+	const auto fold = [&](T res, const cell_t* a, std::size_t len) {
+		for(std::size_t i = 0; i < len; ++i)
+		 res = op(res, (T)a[i]);
+		return res;
+	};
+	return detail::reduce_rows(grid, init, fold, op, n_threads);
+}
+
+template<class Grid>
+long long sum(const Grid& grid, unsigned n_threads = 0) {
+	return reduce(grid, 0ll, add_op(), n_threads); }
+
+template<class Grid>
+typename Grid::cell_traits_t::cell_t min_value(const Grid& grid,
+	unsigned n_threads = 0)
+{
+	using cell_t = typename Grid::cell_traits_t::cell_t;
+	return reduce(grid, std::numeric_limits<cell_t>::max(), min_op(),
+		n_threads);
+}
+
+template<class Grid>
+typename Grid::cell_traits_t::cell_t max_value(const Grid& grid,
+	unsigned n_threads = 0)
+{
+	using cell_t = typename Grid::cell_traits_t::cell_t;
+	return reduce(grid, std::numeric_limits<cell_t>::min(), max_op(),
+		n_threads);
+}
+
+//! number of cells equal to @a value
+template<class Grid>
+std::size_t count(const Grid& grid,
+	const typename Grid::cell_traits_t::cell_t& value,
+	unsigned n_threads = 0)
+{
+	using cell_t = typename Grid::cell_traits_t::cell_t;
+	const auto fold = [&](std::size_t res, const cell_t* a, std::size_t len) {
+		for(std::size_t i = 0; i < len; ++i)
+		 res += (a[i] == value);
+		return res;
+	};
+	return detail::reduce_rows(grid, (std::size_t)0, fold, add_op(),
+		n_threads);
+}
+
+//! whether all cells equal @a value
+template<class Grid>
+bool all_equal(const Grid& grid,
+	const typename Grid::cell_traits_t::cell_t& value,
+	unsigned n_threads = 0)
+{
+	return count(grid, value, n_threads) == grid.human_dim().area();
+}
+
+}
+
+#endif // GRID_ALGEBRA_H
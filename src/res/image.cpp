@@ -19,6 +19,8 @@
 /*************************************************************************/
 
 #include <climits>
+#include <istream>
+#include <ostream>
 #include "image.h"
 
 void rgb::from_str(const char* color_str)
@@ -45,22 +47,23 @@ ColorTable::ColorTable(rgb _min_color, rgb _max_color, int _min_val, int _max_va
 	 step_size = (max_color - min_color)/(max_val-min_val);
 }
 
-void tga::print_header(FILE* fp, const dimension& dim, const ColorTable& ct)
+void tga::print_header(FILE* fp, const dimension& dim, int num_colors,
+	bool rle)
 {
 	const char BITS_PER_COLOR = 24;
 	const char BIT_PER_PIXEL = 8; // GIMP does not allow 16
 
 	// 0-0: no image id field
 	// 1-1: color map? yes
-	// 2-2: image type: color mapped
-	fwrite("\x00\x01\x01", 1, 3, fp);
+	// 2-2: image type: color mapped (1), or RLE color mapped (9)
+	fwrite(rle ? "\x00\x01\x09" : "\x00\x01\x01", 1, 3, fp);
 
 	// color map:
 	// 0-1: index of first entry (=0)
 	// 2-3: number of entries
 	// 4-4: bpp to describe each color
 	fwrite("\x00\x00", 1, 2, fp);
-	const short number_of_colors = ct.num_colors();
+	const short number_of_colors = num_colors;
 	fwrite(&number_of_colors, 1, 2, fp);
 	fwrite(&BITS_PER_COLOR, 1, 1, fp);
 
@@ -68,9 +71,9 @@ void tga::print_header(FILE* fp, const dimension& dim, const ColorTable& ct)
 	// 2-3: y-origin (=0)
 	fwrite("\x00\x00\x00\x00", 1, 4, fp);
 
-	const short width = dim.width() - 2;
+	const short width = dim.width();
 	fwrite(&width, 2, 1,  fp);
-	const short height = dim.height() - 2;
+	const short height = dim.height();
 	fwrite(&height, 2, 1, fp);
 
 	// 0: pixel depth (=BPP)
@@ -79,7 +82,12 @@ void tga::print_header(FILE* fp, const dimension& dim, const ColorTable& ct)
 	// 1: bits 6-7: reserved to be 0
 	fwrite(&BIT_PER_PIXEL, 1, 1, fp);
 	fwrite("\x20", 1, 1, fp);
+}
 
+void tga::print_header(FILE* fp, const dimension& dim, const ColorTable& ct)
+{
+	print_header(fp, dimension(dim.width() - 2, dim.height() - 2),
+		ct.num_colors(), false);
 }
 
 void tga::print_color_map(FILE* fp, const ColorTable& ct)
@@ -114,6 +122,37 @@ void tga::print_footer(FILE* fp)
 	fwrite("TRUEVISION-XFILE.\x00",1,18,fp);
 }
 
+void tga::print_rle_row(FILE* fp, const unsigned char* row, int width,
+	std::vector<unsigned char>& buf)
+{
+	// packets must not cross rows, and contain at most 128 pixels
+	buf.clear();
+	for(int i = 0; i < width; )
+	{
+		int run = 1;
+		while(i + run < width && run < 128 && row[i + run] == row[i])
+		 ++run;
+		if(run > 1)
+		{
+			buf.push_back(0x80 | (run - 1));
+			buf.push_back(row[i]);
+			i += run;
+		}
+		else
+		{
+			// raw packet, up to where the next run starts
+			int j = i + 1;
+			while(j < width && j - i < 128
+				&& !(j + 1 < width && row[j] == row[j + 1]))
+			 ++j;
+			buf.push_back(j - i - 1);
+			buf.insert(buf.end(), row + i, row + j);
+			i = j;
+		}
+	}
+	fwrite(buf.data(), 1, buf.size(), fp);
+}
+
 void print_to_tga(FILE* fp, const ColorTable& ct,
 	const std::vector<int>& grid, const dimension& dim)
 {
@@ -123,3 +162,164 @@ void print_to_tga(FILE* fp, const ColorTable& ct,
 	tga::print_footer(fp);
 }
 
+
+namespace pam
+{
+
+header_t read_header(std::istream& in, bool magic_read)
+{
+	header_t hdr;
+	hdr.depth = 0;
+	hdr.tupltype.clear();
+
+	std::string token;
+	if(!magic_read && (!(in >> token) || token != "P7"))
+	 throw "Input is no PAM image (expected P7).";
+	while(in >> token && token != "ENDHDR")
+	{
+		if(token[0] == '#')
+		 std::getline(in, token);
+		else if(token == "WIDTH")
+		 in >> hdr.width;
+		else if(token == "HEIGHT")
+		 in >> hdr.height;
+		else if(token == "DEPTH")
+		 in >> hdr.depth;
+		else if(token == "MAXVAL")
+		 in >> hdr.maxval;
+		else if(token == "TUPLTYPE")
+		 in >> hdr.tupltype;
+		else
+		 throw "Unknown token in PAM header.";
+	}
+	if(!in || in.get() != '\n')
+	 throw "Incomplete PAM header.";
+	if(hdr.width <= 0 || hdr.height <= 0 || hdr.depth <= 0
+		|| hdr.depth > 4 || hdr.maxval != 255)
+	 throw "Only PAM images with 1 to 4 channels of 8 bit are supported.";
+	return hdr;
+}
+
+static std::string header_str(const header_t& hdr)
+{
+	std::string res = "P7\nWIDTH " + std::to_string(hdr.width)
+		+ "\nHEIGHT " + std::to_string(hdr.height)
+		+ "\nDEPTH " + std::to_string(hdr.depth)
+		+ "\nMAXVAL " + std::to_string(hdr.maxval);
+	if(!hdr.tupltype.empty())
+	 res += "\nTUPLTYPE " + hdr.tupltype;
+	return res + "\nENDHDR\n";
+}
+
+void write_header(std::ostream& out, const header_t& hdr)
+{
+	out << header_str(hdr);
+}
+
+void write_header(FILE* fp, const header_t& hdr)
+{
+	fputs(header_str(hdr).c_str(), fp);
+}
+
+}
+
+palette_t::palette_t(const ColorTable& ct) :
+	ct(ct),
+	bgr(3 * ct.num_colors())
+{
+	if(ct.num_colors() > 256)
+	 throw "Palettes are limited to 256 colors.";
+	unsigned char* ptr = bgr.data();
+	for(ColorTable::const_iterator itr(ct); itr.valid(); ++itr, ptr += 3)
+	 itr->to_24bit((char*)ptr);
+}
+
+void palette_t::to_rgb(const unsigned char* idx, std::size_t n,
+	unsigned char* out) const
+{
+	for(std::size_t i = 0; i < n; ++i, out += 3)
+	{
+		const unsigned char* c = bgr.data() + 3 * idx[i];
+		out[0] = c[2]; out[1] = c[1]; out[2] = c[0];
+	}
+}
+
+namespace
+{
+
+class tga_writer_t : public frame_writer_t
+{
+	int width;
+	std::vector<unsigned char> buf;
+public:
+	using frame_writer_t::frame_writer_t;
+	void begin(FILE* fp, const dimension& dim)
+	{
+		width = dim.width();
+		tga::print_header(fp, dim, palette.num_colors(), true);
+		fwrite(palette.color_map().data(), 1,
+			palette.color_map().size(), fp);
+	}
+	void row(FILE* fp, const unsigned char* idx) {
+		tga::print_rle_row(fp, idx, width, buf); }
+	void end(FILE* fp) { tga::print_footer(fp); }
+};
+
+//! base for the uncompressed RGB formats
+class rgb_writer_t : public frame_writer_t
+{
+	std::vector<unsigned char> buf;
+public:
+	using frame_writer_t::frame_writer_t;
+	void begin(FILE* fp, const dimension& dim)
+	{
+		buf.resize(3 * dim.width());
+		print_header(fp, dim);
+	}
+	void row(FILE* fp, const unsigned char* idx)
+	{
+		palette.to_rgb(idx, buf.size() / 3, buf.data());
+		fwrite(buf.data(), 1, buf.size(), fp);
+	}
+	virtual void print_header(FILE* fp, const dimension& dim) = 0;
+};
+
+class pam_writer_t : public rgb_writer_t
+{
+public:
+	using rgb_writer_t::rgb_writer_t;
+	void print_header(FILE* fp, const dimension& dim)
+	{
+		pam::header_t hdr;
+		hdr.width = dim.width();
+		hdr.height = dim.height();
+		hdr.depth = 3;
+		hdr.tupltype = "RGB";
+		pam::write_header(fp, hdr);
+	}
+};
+
+class ppm_writer_t : public rgb_writer_t
+{
+public:
+	using rgb_writer_t::rgb_writer_t;
+	void print_header(FILE* fp, const dimension& dim) {
+		fprintf(fp, "P6\n%d %d\n255\n", (int)dim.width(),
+			(int)dim.height());
+	}
+};
+
+}
+
+frame_writer_t* frame_writer_t::make(const char* format,
+	const palette_t& palette)
+{
+	if(!strcmp(format, "tga"))
+	 return new tga_writer_t(palette);
+	else if(!strcmp(format, "pam"))
+	 return new pam_writer_t(palette);
+	else if(!strcmp(format, "ppm"))
+	 return new ppm_writer_t(palette);
+	else
+	 throw "Unknown image format, expected tga, pam or ppm.";
+}
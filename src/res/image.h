@@ -23,6 +23,9 @@
 
 #include <cstdio>
 #include <cstring>
+#include <iosfwd>
+#include <string>
+#include <vector>
 
 #include "geometry.h"
 
@@ -91,16 +94,85 @@ public:
 	ColorTable(rgb _min_color, rgb _max_color, int _min_val, int _max_val);
 };
 
+//! colors of a ColorTable, computed once and reused for all pixels
+//!   and frames
+class palette_t
+{
+	const ColorTable ct;
+	std::vector<unsigned char> bgr; //!< 3 bytes per color, like in TGA
+public:
+	palette_t(const ColorTable& ct);
+	int num_colors() const { return ct.num_colors(); }
+	//! palette index of grid value @a value
+	unsigned char index(int value) const {
+		return (unsigned char)ct.index_2_ct_index(value); }
+	//! the color map, blue-green-red for each color
+	const std::vector<unsigned char>& color_map() const { return bgr; }
+	//! converts @a n palette indices to red-green-blue triples
+	void to_rgb(const unsigned char* idx, std::size_t n,
+		unsigned char* out) const;
+};
+
 namespace tga
 {
+	//! @param dim dimension without border
+	void print_header(FILE* fp, const dimension& dim, int num_colors,
+		bool rle);
+	//! @param dim dimension including a border of 1
 	void print_header(FILE* fp, const dimension& dim, const ColorTable& ct);
 	void print_color_map(FILE* fp, const ColorTable& ct);
 	void print_image_map(FILE* fp, const std::vector<int>& grid,
 		const ColorTable& ct);
 	void print_footer(FILE* fp);
+	//! writes one row of palette indices as RLE packets
+	//! @param buf buffer for the packets, reused between calls
+	void print_rle_row(FILE* fp, const unsigned char* row, int width,
+		std::vector<unsigned char>& buf);
 }
 
 void print_to_tga(FILE* fp, const ColorTable& ct,
 	const std::vector<int>& grid, const dimension& dim);
 
+//! portable arbitrary map (netpbm P7), see `man pam'
+namespace pam
+{
+	struct header_t
+	{
+		int width = 0, height = 0;
+		int depth = 4; //!< number of channels
+		int maxval = 255;
+		std::string tupltype = "RGB_ALPHA";
+	};
+
+	//! reads the header including ENDHDR, the stream is at the
+	//!   first pixel afterwards
+	//! @param magic_read true if the "P7" has already been read
+	//! @throw if the stream does not start with a PAM header
+	header_t read_header(std::istream& in, bool magic_read = false);
+	void write_header(std::ostream& out, const header_t& hdr);
+	void write_header(FILE* fp, const header_t& hdr);
+}
+
+/**
+ * @brief Writes images row by row, such that no image needs to be
+ *   in memory. Multiple frames can be written to the same file.
+ */
+class frame_writer_t
+{
+protected:
+	const palette_t& palette;
+public:
+	frame_writer_t(const palette_t& palette) : palette(palette) {}
+	//! @param dim dimension without border
+	virtual void begin(FILE* fp, const dimension& dim) = 0;
+	//! writes the next row, given as dim.width() palette indices
+	virtual void row(FILE* fp, const unsigned char* idx) = 0;
+	virtual void end(FILE* fp) { (void)fp; }
+	virtual ~frame_writer_t() {}
+
+	//! @param format one of "tga" (RLE), "pam" or "ppm"
+	static frame_writer_t* make(const char* format,
+		const palette_t& palette);
+};
+
 #endif // IMAGE_H
@@ -164,6 +164,7 @@ bool get_input(const char* shell_command)
 
 	close(pipefd[1]); /* Close unused write end */
 	dup2(pipefd[0], STDIN_FILENO);
+	clearerr(stdin); // stdin has probably been read until eof before
 	return true;
 }
 
@@ -22,6 +22,7 @@
 #define GRIDFILE_H
 
 #include <string>
+#include <vector>
 
 #include "secfile.h"
 #include "grid.h"
@@ -48,7 +49,23 @@ public:
 	int32_t operator()(const grid_t& g, point p) const {
 		return eqs.calculate_next_state_old<
 			def_coord_traits, def_cell_traits
-			>(&g[p], p, g.human_dim());
+			>(&g[p], p, g.internal_dim());
+	}
+
+	//! colors of all points of @a g, in the order of g.points()
+	std::vector<int32_t> operator()(const grid_t& g) const
+	{
+		const dimension dim = g.human_dim();
+		std::vector<int32_t> res(dim.area());
+		for(int y = 0; y < (int)dim.height(); ++y)
+		{
+			const point p(0, y);
+			eqs.calculate_next_states_line<
+				def_coord_traits, def_cell_traits
+				>(&g[p], p, dim.width(), g.internal_dim(),
+				res.data() + y * dim.width());
+		}
+		return res;
 	}
 
 	static bool text_black(int32_t val) {
@@ -0,0 +1,318 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "asm_basic.h"
+#include "grid_algebra.h"
+#include "image.h"
+#include "stack_algorithm.h"
+#include "pipeline.h"
+
+namespace pipeline
+{
+
+namespace
+{
+
+using tokens_t = std::vector<std::string>;
+
+void assert_args(const tokens_t& tokens, std::size_t min, std::size_t max)
+{
+	if(tokens.size() < min + 1 || tokens.size() > max + 1)
+	 throw "Wrong number of arguments for a pipeline stage.";
+}
+
+//! like core/create
+class create_stage : public stage_t
+{
+	const dimension dim;
+	const int value;
+public:
+	create_stage(const tokens_t& t) :
+		dim(atoi(t.at(1).c_str()), atoi(t.at(2).c_str())),
+		value(t.size() > 3 ? atoi(t[3].c_str()) : 0) {}
+	bool is_source() const { return true; }
+	grid_t operator()(grid_t&& , std::istream& , std::ostream& ) {
+		return grid_t(dim, 1, value); }
+};
+
+//! like algo/id
+class id_stage : public stage_t
+{
+	const dimension dim;
+public:
+	id_stage(const tokens_t& t) :
+		dim(atoi(t.at(1).c_str()), atoi(t.at(2).c_str())) {}
+	bool is_source() const { return true; }
+	grid_t operator()(grid_t&& , std::istream& , std::ostream& ) {
+		return sandpile::get_identity(dim); }
+};
+
+//! reads a grid from a file, or from the pipeline's input
+class read_stage : public stage_t
+{
+	const std::string filename;
+public:
+	read_stage(const tokens_t& t) :
+		filename(t.size() > 1 ? t[1] : "") {}
+	bool is_source() const { return true; }
+	grid_t operator()(grid_t&& , std::istream& is, std::ostream& )
+	{
+		if(filename.empty())
+		 return grid_t(is, 1);
+		std::ifstream ifs(filename);
+		if(!ifs.good())
+		 throw "Could not open input file for pipeline.";
+		return grid_t(ifs, 1);
+	}
+};
+
+//! like algo/fix s
+class fix_stage : public stage_t
+{
+public:
+	grid_t operator()(grid_t&& grid, std::istream& , std::ostream& )
+	{
+		sandpile::stabilize(grid);
+		grid.reset_border(); // the algorithm modifies the border
+		return std::move(grid);
+	}
+};
+
+//! like algo/random_throw random <number> <seed> s
+class random_throw_stage : public stage_t
+{
+	const unsigned number, seed;
+public:
+	random_throw_stage(const tokens_t& t) :
+		number(atoi(t.at(1).c_str())),
+		seed(atoi(t.at(2).c_str())) {}
+	grid_t operator()(grid_t&& grid, std::istream& , std::ostream& )
+	{
+		const dimension dim = grid.internal_dim();
+		sandpile::array_stack container(dim.area_without_border() * 2);
+		sandpile::throw_grains(grid.data(), dim,
+			sandpile::random_throw_sequence(dim, number, seed),
+			container);
+		grid.reset_border(); // the algorithm modifies the border
+		return std::move(grid);
+	}
+};
+
+//! like math/comb, but the second grid comes from a source stage
+class comb_stage : public stage_t
+{
+	const std::string op_str;
+	std::unique_ptr<stage_t> other;
+public:
+	comb_stage(const tokens_t& t) :
+		op_str(t.at(1))
+	{
+		if(op_str != "add" && op_str != "sub" && op_str != "mul"
+			&& op_str != "max" && op_str != "min")
+		 throw "Unknown comb operator. Supported: add, sub, mul, max, min.";
+
+		other = make_stage(tokens_t(t.begin() + 2, t.end()));
+		if(!other->is_source())
+		 throw "The second grid of comb must come from a source stage.";
+	}
+	grid_t operator()(grid_t&& grid, std::istream& is, std::ostream& os)
+	{
+		const grid_t grid2 = (*other)(grid_t(1), is, os);
+		if(op_str == "add") grid_algebra::add(grid, grid2);
+		else if(op_str == "sub") grid_algebra::sub(grid, grid2);
+		else if(op_str == "mul") grid_algebra::mul(grid, grid2);
+		else if(op_str == "max") grid_algebra::max(grid, grid2);
+		else grid_algebra::min(grid, grid2);
+		return std::move(grid);
+	}
+};
+
+//! like io/to_tga
+class to_tga_stage : public stage_t
+{
+	rgb min_color, max_color;
+	int min_val, max_val;
+	const std::string filename;
+public:
+	to_tga_stage(const tokens_t& t) :
+		min_color(255, 255, 255), max_color(0, 0, 0),
+		min_val(t.size() > 3 ? atoi(t[3].c_str()) : 0),
+		max_val(t.size() > 4 ? atoi(t[4].c_str()) : 3),
+		filename(t.size() > 5 ? t[5] : "")
+	{
+		if(t.size() > 1) min_color.from_str(t[1].c_str());
+		if(t.size() > 2) max_color.from_str(t[2].c_str());
+	}
+	bool is_sink() const { return true; }
+	grid_t operator()(grid_t&& grid, std::istream& , std::ostream& os)
+	{
+		// without a file, the image is written to memory first, since
+		// print_to_tga() needs a FILE
+		char* buf = nullptr;
+		std::size_t size = 0;
+		FILE* const fp = filename.empty()
+			? open_memstream(&buf, &size) : fopen(filename.c_str(), "w");
+		if(!fp)
+		 throw "Error opening outfile";
+		print_to_tga(fp, ColorTable(min_color, max_color,
+			min_val, max_val), grid.data(), grid.internal_dim());
+		fclose(fp);
+		if(buf)
+		{
+			os.write(buf, size);
+			os.flush();
+			free(buf);
+		}
+		return std::move(grid);
+	}
+};
+
+//! writes the grid as text, to a file or to the pipeline's output
+class write_stage : public stage_t
+{
+	const std::string filename;
+public:
+	write_stage(const tokens_t& t) :
+		filename(t.size() > 1 ? t[1] : "") {}
+	bool is_sink() const { return true; }
+	grid_t operator()(grid_t&& grid, std::istream& , std::ostream& os)
+	{
+		if(filename.empty())
+		 os << grid;
+		else
+		{
+			std::ofstream ofs(filename);
+			ofs << grid;
+		}
+		return std::move(grid);
+	}
+};
+
+}
+
+std::unique_ptr<stage_t> make_stage(const tokens_t& t)
+{
+	if(t.empty())
+	 throw "Empty pipeline stage.";
+	const std::string& name = t[0];
+	stage_t* res;
+	if(name == "create")
+	{
+		assert_args(t, 2, 3);
+		res = new create_stage(t);
+	}
+	else if(name == "id")
+	{
+		assert_args(t, 2, 2);
+		res = new id_stage(t);
+	}
+	else if(name == "read")
+	{
+		assert_args(t, 0, 1);
+		res = new read_stage(t);
+	}
+	else if(name == "fix")
+	{
+		assert_args(t, 0, 0);
+		res = new fix_stage();
+	}
+	else if(name == "random_throw")
+	{
+		assert_args(t, 2, 2);
+		res = new random_throw_stage(t);
+	}
+	else if(name == "comb")
+	{
+		assert_args(t, 2, t.size());
+		res = new comb_stage(t);
+	}
+	else if(name == "to_tga")
+	{
+		assert_args(t, 0, 5);
+		res = new to_tga_stage(t);
+	}
+	else if(name == "write")
+	{
+		assert_args(t, 0, 1);
+		res = new write_stage(t);
+	}
+	else
+	 throw "Unknown pipeline stage.";
+	return std::unique_ptr<stage_t>(res);
+}
+
+void pipeline_t::add(const std::string& description)
+{
+	std::istringstream iss(description);
+	tokens_t tokens;
+	std::string token;
+	while(iss >> token)
+	 tokens.push_back(token);
+	stages.push_back(entry_t { description, make_stage(tokens), 0. });
+}
+
+void pipeline_t::run(std::istream& is, std::ostream& os)
+{
+	using clock = std::chrono::steady_clock;
+	const auto seconds_since = [](const clock::time_point& start) {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	};
+
+	grid_t grid(1);
+	clock::time_point start = clock::now();
+	read_input = stages.empty() || !stages.front().stage->is_source();
+	if(read_input)
+	 grid = grid_t(is, 1);
+	input_seconds = seconds_since(start);
+
+	for(entry_t& e : stages)
+	{
+		start = clock::now();
+		grid = (*e.stage)(std::move(grid), is, os);
+		e.seconds = seconds_since(start);
+	}
+
+	start = clock::now();
+	write_output = stages.empty() || !stages.back().stage->is_sink();
+	if(write_output)
+	 os << grid;
+	output_seconds = seconds_since(start);
+}
+
+void pipeline_t::print_timings(std::ostream& os) const
+{
+	const auto print = [&](const std::string& name, double seconds) {
+		os << name << ": " << seconds * 1000. << " ms" << std::endl; };
+	if(read_input)
+	 print("(input)", input_seconds);
+	for(const entry_t& e : stages)
+	 print(e.description, e.seconds);
+	if(write_output)
+	 print("(output)", output_seconds);
+}
+
+}
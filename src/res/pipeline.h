@@ -0,0 +1,93 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+//! @file pipeline.h runs chains of toolsuite stages in one process
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "grid.h"
+
+namespace pipeline
+{
+
+/**
+ * @brief One stage of a pipeline, corresponding to one toolsuite program.
+ *
+ * All grids passed between stages have border width 1, like the grids
+ * the text based programs read.
+ */
+class stage_t
+{
+public:
+	//! whether the stage ignores its input grid, like core/create
+	virtual bool is_source() const { return false; }
+	//! whether the stage writes the grid itself, like io/to_tga
+	virtual bool is_sink() const { return false; }
+	//! runs the stage on @a grid and returns the result
+	//! @param is, os the streams of pipeline_t::run(), which stages
+	//!   use instead of stdin and stdout
+	virtual grid_t operator()(grid_t&& grid, std::istream& is,
+		std::ostream& os) = 0;
+	virtual ~stage_t() {}
+};
+
+//! creates a stage from its name and its arguments, like
+//!   {"create", "10", "10"}
+std::unique_ptr<stage_t> make_stage(const std::vector<std::string>& tokens);
+
+/**
+ * @brief Chain of stages which pass their grids by move.
+ *
+ * If the first stage is no source, the input grid is read first.
+ * If the last stage is no sink, the result is written as text.
+ */
+class pipeline_t
+{
+	struct entry_t
+	{
+		std::string description;
+		std::unique_ptr<stage_t> stage;
+		double seconds;
+	};
+	std::vector<entry_t> stages;
+	bool read_input = false, write_output = false;
+	double input_seconds = 0., output_seconds = 0.;
+
+public:
+	//! adds a stage, @a description is like "create 10 10"
+	void add(const std::string& description);
+
+	//! runs all stages, reading from @a is and writing to @a os
+	//!   if required
+	void run(std::istream& is, std::ostream& os);
+
+	//! prints the time spent in each stage of the last run()
+	void print_timings(std::ostream& os) const;
+};
+
+}
+
+#endif // PIPELINE_H
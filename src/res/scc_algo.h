@@ -79,9 +79,14 @@ public:
 #ifdef SCC_ALGO_DEBUG
 		std::cerr << "scc algo: on_finish_new_edge: " << v_src << ", " << v_tar << std::endl;
 #endif
-		auto& src = find(v_src);
-		const auto& tar = find(v_tar);
-		src.lowlink = std::min(src.lowlink, tar.lowlink);
+		// if v_tar has already been popped as an scc root, it is
+		// not part of v_src's scc
+		const auto tar_itr = node_data.find(v_tar);
+		if(tar_itr != node_data.end())
+		{
+			auto& src = find(v_src);
+			src.lowlink = std::min(src.lowlink, tar_itr->second.lowlink);
+		}
 	}
 
 	//! Checks whether connecting to v_tar means drawing a cycle
@@ -24,12 +24,14 @@
 namespace sca {
 namespace sim {
 
-ulator::sim_wrapper ulator::wraps[4]
+ulator::sim_wrapper ulator::wraps[6]
 {
 	{ sim_type::end, "end" },
 	{ sim_type::role, "role" },
 	{ sim_type::more, "more" },
-	{ sim_type::anim, "anim" }
+	{ sim_type::anim, "anim" },
+	{ sim_type::record, "record" },
+	{ sim_type::bench, "bench" }
 };
 
 ulator::sim_type ulator::type_by_str(const char *str)
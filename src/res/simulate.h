@@ -36,6 +36,8 @@ protected:
 		role,
 		more,
 		anim,
+		record, //!< binary trajectory, see trajectory.h
+		bench, //!< no output, only timings
 		undefined
 	};
 	sim_type type_by_str(const char* str);
@@ -46,7 +48,7 @@ private:
 		const char* str;
 	};
 
-	static sim_wrapper wraps[4]; // TODO: why is 4 needed?
+	static sim_wrapper wraps[6]; // TODO: why is 6 needed?
 };
 
 }
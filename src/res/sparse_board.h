@@ -0,0 +1,165 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+//! @file sparse_board.h unbounded board, stored as tiles which are
+//!   allocated on demand
+
+#ifndef SPARSE_BOARD_H
+#define SPARSE_BOARD_H
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "geometry.h"
+
+/**
+ * @brief Unbounded grid whose cells are 0 unless they are set.
+ *
+ * The board is cut into square tiles of side 2^tile_log. A tile is only
+ * allocated if one of its cells is set to a value other than 0, and
+ * release_empty() frees tiles whose cells are all 0 again. Thus, memory
+ * is proportional to the occupied area, not to the coordinates used.
+ *
+ * Unlike _grid_t, the board has no border, and cells can not be
+ * accessed through pointers to their neighbours. Use gather() to get
+ * a contiguous copy of an area.
+ */
+template<class Traits, class CellTraits>
+class sparse_board_t
+{
+	using cell_t = typename CellTraits::cell_t;
+	using coord_t = typename Traits::coord_t;
+	using point = _point<Traits>;
+	using dimension = _dimension<Traits>;
+
+	static constexpr unsigned tile_log = 6;
+	static constexpr coord_t tile_side = (coord_t)1 << tile_log;
+	static constexpr coord_t tile_mask = tile_side - 1;
+
+	struct tile_t
+	{
+		std::vector<cell_t> cells;
+		std::size_t non_zero = 0;
+		tile_t() : cells(tile_side * tile_side, 0) {}
+	};
+
+	std::unordered_map<uint64_t, tile_t> tiles;
+	std::vector<uint64_t> emptied; //!< tiles which became all 0
+
+	//! tile coordinates use arithmetic shifts, so they round down
+	static uint64_t key(coord_t tx, coord_t ty) {
+		return ((uint64_t)(uint32_t)tx << 32) | (uint32_t)ty; }
+	static uint64_t key_of(const point& p) {
+		return key(p.x >> tile_log, p.y >> tile_log); }
+	static std::size_t offset_of(const point& p) {
+		return ((p.y & tile_mask) << tile_log) + (p.x & tile_mask); }
+
+public:
+	//! value of the cell at @a p, 0 if it has never been set
+	cell_t operator[](const point& p) const
+	{
+		const auto itr = tiles.find(key_of(p));
+		return (itr == tiles.end()) ? 0 : itr->second.cells[offset_of(p)];
+	}
+
+	//! sets the cell at @a p to @a v, allocating its tile if needed
+	void set(const point& p, cell_t v)
+	{
+		auto itr = tiles.find(key_of(p));
+		if(itr == tiles.end())
+		{
+			if(!v)
+			 return;
+			itr = tiles.emplace(key_of(p), tile_t()).first;
+		}
+		cell_t& c = itr->second.cells[offset_of(p)];
+		itr->second.non_zero += (v != 0) - (c != 0);
+		if(c && !v && !itr->second.non_zero)
+		 emptied.push_back(itr->first);
+		c = v;
+	}
+
+	/**
+	 * @brief copies the cells of the rectangle at @a ul with dimension
+	 *   @a dim row by row into @a out
+	 * This is fast if the rectangle lies inside one tile.
+	 */
+	void gather(const point& ul, const dimension& dim, cell_t* out) const
+	{
+		const point lr(ul.x + (coord_t)dim.dx() - 1,
+			ul.y + (coord_t)dim.dy() - 1);
+		if(key_of(ul) == key_of(lr))
+		{
+			const auto itr = tiles.find(key_of(ul));
+			if(itr == tiles.end())
+			 std::fill(out, out + dim.area(), 0);
+			else for(coord_t y = ul.y; y <= lr.y; ++y, out += dim.dx())
+			{
+				const cell_t* row = itr->second.cells.data()
+					+ offset_of(point(ul.x, y));
+				std::copy(row, row + dim.dx(), out);
+			}
+		}
+		else
+		{
+			for(coord_t y = ul.y; y <= lr.y; ++y)
+			for(coord_t x = ul.x; x <= lr.x; ++x)
+			 *(out++) = (*this)[point(x, y)];
+		}
+	}
+
+	//! calls @a ftor(p, v) for all cells with values v other than 0
+	template<class Functor>
+	void for_each_non_zero(const Functor& ftor) const
+	{
+		for(const auto& pr : tiles)
+		if(pr.second.non_zero)
+		{
+			const coord_t tx = (coord_t)(uint32_t)(pr.first >> 32),
+				ty = (coord_t)(uint32_t)pr.first;
+			for(coord_t y = 0; y < tile_side; ++y)
+			for(coord_t x = 0; x < tile_side; ++x)
+			if(const cell_t v = pr.second.cells[(y << tile_log) + x])
+			 ftor(point(tx * tile_side + x, ty * tile_side + y), v);
+		}
+	}
+
+	//! frees all tiles whose cells are all 0
+	//! complexity: number of tiles which became all 0 since the last call
+	void release_empty()
+	{
+		for(const uint64_t k : emptied)
+		{
+			const auto itr = tiles.find(k);
+			if(itr != tiles.end() && !itr->second.non_zero)
+			 tiles.erase(itr);
+		}
+		emptied.clear();
+	}
+
+	std::size_t num_tiles() const { return tiles.size(); }
+	//! number of bytes used for cells
+	std::size_t cell_bytes() const {
+		return tiles.size() * tile_side * tile_side * sizeof(cell_t); }
+};
+
+#endif // SPARSE_BOARD_H
@@ -26,6 +26,8 @@
 #include <vector>
 #include <type_traits>
 #include "grid.h"
+#include "io.h"
+#include "random.h"
 
 namespace sandpile
 {
@@ -362,6 +364,37 @@ inline void l_hint(std::vector<T>& grid, const dimension& dim, const uint32_t hi
 	grid[hint]++;
 }
 
+/**
+	Internal indices of @a number grains, thrown at random cells by
+	the global random numbers seeded with @a seed.
+	@param dim dimension including a border of 1
+*/
+inline std::vector<int> random_throw_sequence(const dimension& dim,
+	unsigned number, unsigned seed)
+{
+	std::vector<int> random_seq(number);
+	sca_random::set_seed(seed);
+	const int area = dim.area_without_border();
+	for(int& r : random_seq)
+	 r = human2internal(sca_random::get_int(area-1), dim.width());
+	return random_seq;
+}
+
+/**
+	Throws a grain at each cell of @a random_seq and develops its
+	avalanche with l_hint() before the next grain is thrown.
+*/
+template<class T, class AvalancheContainer>
+inline void throw_grains(std::vector<T>& grid, const dimension& dim,
+	const std::vector<int>& random_seq, AvalancheContainer& array)
+{
+	for(const int r : random_seq)
+	{
+		grid[r]++;
+		l_hint<T>(grid, dim, r, array);
+	}
+}
+
 #if 0
 template<class AvalancheContainer>
 inline void l2_hint(std::vector<int>* grid, const dimension* dim, int hint, AvalancheContainer* array, FILE* avalanche_fp)
@@ -0,0 +1,304 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+//! @file trajectory.h binary recordings of simulations, with keyframes
+//!   and deltas, which can be read at any round
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "grid.h"
+#include "io/serial.h"
+
+/*
+ * file layout, fixed size numbers in host byte order:
+ *   header: "SCATRAJ1", int32 width, height, keyframe interval
+ *   frames: uint8 kind, int32 round, uint32 number of bytes, then
+ *     'K' (keyframe): width * height values, row by row
+ *     'D' (delta): number of cells, then for each cell the distance of
+ *       its index (y * width + x) to the previous one, and its value
+ *   index: uint32 number of frames, uint32 number of keyframes,
+ *     number of keyframes * (int32 round, uint64 file offset)
+ *   footer: uint64 file offset of the index, "SCATRIDX"
+ * frame contents are LEB128 varints, values are zigzag encoded, since
+ * most cells of common CAs have small values
+ */
+
+namespace sca { namespace io {
+
+//! writes one frame per round, the first one as a keyframe
+class trajectory_writer_t
+{
+	struct key_t { int32_t round; uint64_t offset; };
+
+	serializer ser;
+	const int32_t width, height, key_interval;
+	int32_t round = 0;
+	uint64_t pos = 0; //!< bytes written, the stream may be a pipe
+	std::vector<key_t> keys;
+	std::vector<uint32_t> idx; //!< delta cells of the current round
+	std::vector<uint8_t> buf; //!< contents of the current frame
+	bool finished = false;
+
+	void put(uint32_t v)
+	{
+		for(; v >= 0x80; v >>= 7)
+		 buf.push_back((v & 0x7F) | 0x80);
+		buf.push_back(v);
+	}
+	void put_value(int32_t v) {
+		put(((uint32_t)v << 1) ^ (uint32_t)(v >> 31)); }
+
+	void write_frame(uint8_t kind)
+	{
+		ser << kind << round << (uint32_t)buf.size();
+		ser.raw((const char*)buf.data(), buf.size());
+		pos += 9 + buf.size();
+	}
+
+	void keyframe(const grid_t& g)
+	{
+		keys.push_back(key_t { round, pos });
+		buf.clear();
+		for(int32_t y = 0; y < height; ++y)
+		{
+			const int* row = &g[point(0, y)];
+			for(int32_t x = 0; x < width; ++x)
+			 put_value(row[x]);
+		}
+		write_frame('K');
+	}
+
+public:
+	//! @param key_interval a keyframe is written at least every
+	//!   @a key_interval rounds
+	trajectory_writer_t(std::ostream& os, const dimension& dim,
+		int key_interval = 64) :
+		ser(os),
+		width(dim.width()),
+		height(dim.height()),
+		key_interval(key_interval)
+	{
+		ser.raw("SCATRAJ1", 8);
+		ser << width << height << this->key_interval;
+		pos += 8 + 3 * sizeof(int32_t);
+	}
+
+	~trajectory_writer_t() { if(!finished) finish(); }
+
+	//! writes the first round, as keyframe
+	void add(const grid_t& g) { keyframe(g); ++round; }
+
+	/**
+	 * @brief writes the next round
+	 * @param changed all points which might have changed since the
+	 *   last round, more do not harm
+	 */
+	void add(const grid_t& g, const std::vector<point>& changed)
+	{
+		idx.clear();
+		for(const point& p : changed)
+		if(g.contains(p))
+		 idx.push_back(p.y * width + p.x);
+
+		// a delta of more than half of the cells is not worth it
+		if(!(round % key_interval)
+			|| idx.size() * 2 >= (std::size_t)width * height)
+		 keyframe(g);
+		else
+		{
+			std::sort(idx.begin(), idx.end());
+			buf.clear();
+			put(idx.size());
+			uint32_t last = 0;
+			for(const uint32_t i : idx)
+			{
+				put(i - last);
+				put_value(g[point(i % width, i / width)]);
+				last = i;
+			}
+			write_frame('D');
+		}
+		++round;
+	}
+
+	//! writes the index, no frames can be added afterwards
+	void finish()
+	{
+		const uint64_t index_pos = pos;
+		ser << (uint32_t)round << (uint32_t)keys.size();
+		for(const key_t& k : keys)
+		 ser << k.round << k.offset;
+		ser << index_pos;
+		ser.raw("SCATRIDX", 8);
+		finished = true;
+	}
+};
+
+//! reads trajectories from a seekable stream
+class trajectory_reader_t
+{
+	struct key_t { int32_t round; uint64_t offset; };
+
+	std::istream& is;
+	deserializer des;
+	int32_t width, height, key_interval;
+	uint32_t n_frames;
+	std::vector<key_t> keys;
+	int32_t cur_round = -1; //!< round of the grid after the last read
+	std::vector<uint8_t> buf; //!< contents of the current frame
+	const uint8_t* ptr;
+
+	uint32_t get()
+	{
+		uint32_t res = 0;
+		for(int shift = 0; ; shift += 7)
+		{
+			if(ptr == buf.data() + buf.size())
+			 throw "Invalid frame in trajectory.";
+			const uint8_t byte = *ptr++;
+			res |= (uint32_t)(byte & 0x7F) << shift;
+			if(!(byte & 0x80))
+			 return res;
+		}
+	}
+	int32_t get_value() {
+		const uint32_t v = get();
+		return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+	}
+
+	void check_magic(const char* magic)
+	{
+		char magic_read[8];
+		if(!is.read(magic_read, 8) || memcmp(magic_read, magic, 8))
+		 throw "Input is no valid trajectory.";
+	}
+
+	//! reads the frame at the current position into @a g
+	void read_frame(grid_t& g)
+	{
+		uint8_t kind;
+		int32_t round;
+		uint32_t size;
+		des >> kind >> round >> size;
+		buf.resize(size);
+		if(!is.read((char*)buf.data(), size))
+		 throw "Trajectory is truncated.";
+		ptr = buf.data();
+
+		if(kind == 'K')
+		{
+			for(int32_t y = 0; y < height; ++y)
+			{
+				int* row = &g[point(0, y)];
+				for(int32_t x = 0; x < width; ++x)
+				 row[x] = get_value();
+			}
+		}
+		else if(kind == 'D')
+		{
+			const uint32_t count = get();
+			uint32_t i = 0;
+			for(uint32_t n = 0; n < count; ++n)
+			{
+				i += get();
+				if(i >= (uint32_t)(width * height))
+				 throw "Invalid frame in trajectory.";
+				g[point(i % width, i / width)] = get_value();
+			}
+		}
+		else
+		 throw "Invalid frame in trajectory.";
+		cur_round = round;
+	}
+
+public:
+	trajectory_reader_t(std::istream& is) :
+		is(is),
+		des(is)
+	{
+		check_magic("SCATRAJ1");
+		des >> width >> height >> key_interval;
+
+		uint64_t index_pos;
+		is.seekg(-8 - (int)sizeof(uint64_t), std::ios_base::end);
+		des >> index_pos;
+		check_magic("SCATRIDX");
+
+		uint32_t n_keys;
+		is.seekg(index_pos);
+		des >> n_frames >> n_keys;
+		keys.resize(n_keys);
+		for(key_t& k : keys)
+		 des >> k.round >> k.offset;
+		if(!is || keys.empty())
+		 throw "Invalid trajectory index.";
+	}
+
+	dimension dim() const { return dimension(width, height); }
+	//! number of recorded rounds
+	int rounds() const { return n_frames; }
+
+	/**
+	 * @brief reads the grid of round @a round into @a g
+	 * Only the frames since the last keyframe before @a round are read,
+	 * or, if it is closer, since the last round read.
+	 * @param g grid of dimension dim(), left as it is if it was the
+	 *   result of the last call
+	 */
+	void seek(int round, grid_t& g)
+	{
+		if(round < 0 || round >= (int)n_frames)
+		 throw "Round is not in the trajectory.";
+
+		// last keyframe <= round
+		std::size_t k = keys.size() - 1;
+		while(keys[k].round > round)
+		 --k;
+		if(cur_round < keys[k].round || cur_round > round)
+		{
+			is.seekg(keys[k].offset);
+			read_frame(g);
+		}
+		while(cur_round < round)
+		 read_frame(g);
+	}
+
+	//! reads the round after the last one that was read into @a g
+	//! @return false if all rounds have been read
+	bool next(grid_t& g)
+	{
+		if(cur_round + 1 >= (int)n_frames)
+		 return false;
+		seek(cur_round + 1, g);
+		return true;
+	}
+};
+
+}}
+
+#endif // TRAJECTORY_H
@@ -0,0 +1,112 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Threads which are started once and then run many short jobs, e.g.
+ * one per pass of a simulation round. The calling thread takes part
+ * as thread 0, so n threads only need n - 1 workers.
+ */
+class worker_pool_t
+{
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable start_cond, done_cond;
+	//! the current job, valid while busy is not 0
+	const std::function<void(unsigned)>* job = nullptr;
+	unsigned n_active = 0; //!< workers 1 .. n_active - 1 run the job
+	unsigned busy = 0; //!< workers which have not finished the job
+	unsigned generation = 0; //!< counts the jobs, to wake up workers
+	bool stop = false;
+
+	//! @param seen the generation before the first job of worker @a t
+	void work(unsigned t, unsigned seen)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for(; ; seen = generation)
+		{
+			start_cond.wait(lock, [&]{
+				return stop || generation != seen; });
+			if(stop)
+			 return;
+			if(t < n_active)
+			{
+				lock.unlock();
+				(*job)(t);
+				lock.lock();
+				if(!--busy)
+				 done_cond.notify_one();
+			}
+		}
+	}
+
+public:
+	worker_pool_t() = default;
+	worker_pool_t(const worker_pool_t& ) = delete;
+	worker_pool_t& operator=(const worker_pool_t& ) = delete;
+
+	~worker_pool_t()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		start_cond.notify_all();
+		for(std::thread& w : workers)
+		 w.join();
+	}
+
+	//! calls @a f(t) for each t in [0, @a n_threads) in parallel and
+	//!   returns when all calls are done. Workers are only started if
+	//!   no previous call needed as many
+	void run(unsigned n_threads, const std::function<void(unsigned)>& f)
+	{
+		if(n_threads <= 1)
+		{
+			f(0);
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			while(workers.size() + 1 < n_threads)
+			 workers.emplace_back(&worker_pool_t::work, this,
+				(unsigned)workers.size() + 1, generation);
+			job = &f;
+			n_active = n_threads;
+			busy = n_threads - 1;
+			++generation;
+		}
+		start_cond.notify_all();
+		f(0);
+		std::unique_lock<std::mutex> lock(mutex);
+		done_cond.wait(lock, [&]{ return !busy; });
+		job = nullptr;
+	}
+};
+
+#endif // WORKER_POOL_H
@@ -255,8 +255,9 @@ void base::_parse()
 		initial_confs.push_back(conf_t(initial_area_all, sim_grid));
 	};
 
+	const auto active = ca.active_map(sim_grid);
 	for(const point& p : ca_n(initial_area_all))
-	if(ca.is_cell_active(sim_grid, p))
+	if(active.contains(p) && active[p])
 	 all_points.insert(p);
 
 	// TODO: inherited odometer which gives elems instead of itrs?
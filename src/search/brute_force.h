@@ -21,11 +21,10 @@
 #ifndef BRUTE_FORCE_H
 #define BRUTE_FORCE_H
 
-#include <boost/bimap.hpp>
-
 #include "stats.h"
 #include "disjoint_sets.h"
 #include "base.h"
+#include "disk_storage.h"
 
 #include "dep_graph.h"
 
@@ -69,6 +68,10 @@ struct pseudo_int
 	friend std::ostream& operator<< (std::ostream& stream,
 		const pseudo_int& i);
 	const pseudo_int& operator+() { return *this; }
+	friend io::serializer& operator<<(io::serializer& s, const pseudo_int& i) {
+		return s << i.u; }
+	friend io::deserializer& operator>>(io::deserializer& s, pseudo_int& i) {
+		return s >> i.u; }
 };
 
 
@@ -78,6 +81,9 @@ using bgrid_t = _grid_t<char_traits, cell_traits<pseudo_int>>;
 class _stack_data : types
 {
 	static int id_counter;
+
+	template<class T>
+	static T fetch(io::deserializer& s) { T t; s >> t; return t; }
 public:
 	//! full patch
 	const patch_t patch;
@@ -133,6 +139,45 @@ public:
 			v_src(v_src)
 			{}
 
+	//! reads a node that has been swapped out, keeping its id
+	_stack_data(io::deserializer& s) :
+		patch(fetch<patch_t>(s)),
+		variable(fetch<std::vector<point>>(s)),
+		new_points(fetch<std::vector<point>>(s)),
+		used(fetch<std::vector<point>>(s)),
+		not_used(fetch<std::vector<point>>(s)),
+		id(fetch<int>(s)),
+		src_id(fetch<int>(s)),
+		parent_edge(fetch<bool>(s)),
+		changable(fetch<bpatch_t>(s)),
+		v_src()
+	{
+		uint64_t res_ptr;
+		s >> res_ptr >> sccs >> next_scc >> next_bitmask;
+		result = reinterpret_cast<result_t*>(res_ptr);
+	}
+
+	//! @note the debug graph vertices are not written
+	friend io::serializer& operator<<(io::serializer& s,
+		const _stack_data& d)
+	{
+		return s << d.patch << d.variable << d.new_points << d.used
+			<< d.not_used << d.id << d.src_id << d.parent_edge
+			<< d.changable << (uint64_t)reinterpret_cast<uintptr_t>(d.result)
+			<< d.sccs << d.next_scc << d.next_bitmask;
+	}
+
+	//! rough estimation of the memory used by *this
+	std::size_t approx_bytes() const
+	{
+		std::size_t pts = variable.size() + new_points.size()
+			+ used.size() + not_used.size();
+		for(const auto& scc : sccs)
+		 pts += scc.size();
+		return sizeof(_stack_data) + pts * sizeof(point)
+			+ (patch.size() + changable.size()) * 64;
+	}
+
 	static int next_id() { return id_counter + 1; }
 };
 
@@ -146,13 +191,13 @@ protected:
 	m_ca_t::n_t readers_of, writers_to;
 
 	using stack_data = _stack_data;
-	std::stack<stack_data> stack;
+	disk_stack_t<stack_data> stack;
 
 	rec_rval_base_t results; //! @deprecated use base::res_graph instead
 
 	stats_t stats;
 
-	using dict_t = boost::bimap<patch_t, int>;
+	using dict_t = patch_dict_t<patch_t>;
 	dict_t dict;
 	scc_algo_t<int> scc_algo;
 
@@ -162,6 +207,15 @@ protected:
 	_grid_t<char_traits, cell_traits<pseudo_int>> recent_grid;
 	_grid_t<char_traits, cell_traits<pseudo_int>> prev_grid;
 
+	//! last next state computed for each cell of sim_grid,
+	//! keyed by the packed neighbourhood
+	struct next_state_memo_t
+	{
+		uint64_t key, value;
+	};
+	std::vector<next_state_memo_t> next_state_memo;
+	static constexpr uint64_t no_key() { return ~(uint64_t)0; }
+
 	mutable grid_t zero_grid, zero_grid_2; //!< can be used temporary. must be zero outside of use
 	// (TODO: use grid_t<bool...>? => measure speedup)
 
@@ -202,6 +256,26 @@ protected:
 		(uint64_t&)_gridgrid[p] = bitgrid.raw_value();
 	}
 
+	//! like ca.next_state(sim_grid, p, ...), but memoized per cell
+	//! @param key is set to the packed neighbourhood of @a p
+	//! @param res is set to the raw value of the next state bitgrid
+	bool next_state_memo_at(const point& p, uint64_t& key, uint64_t& res)
+	{
+		if(!ca.neighbourhood_key(sim_grid, p, key))
+		 return false;
+		next_state_memo_t& memo = next_state_memo[sim_grid.index_h(p)];
+		if(memo.key == key)
+		 stats.inform_memo_hit();
+		else
+		{
+			stats.inform_memo_miss();
+			memo.key = key;
+			memo.value = ca.next_state_of_key(key);
+		}
+		res = memo.value;
+		return true;
+	}
+
 	bitgrid_t next_state_at(const point& p) const {
 		return bitgrid_t(2/*TODO*/, dimension(n_out.size(), 1),
 			0, (uint64_t&)recent_grid[p]);
@@ -299,12 +373,16 @@ protected:
 		 * refresh recent_grid
 		 */
 
+		std::vector<point> new_vari;
+		{
+		stats_t::phase_timer timer(stats, phase_t::next_state);
+
 		for(const point& p : readers_of(activated))
 		{
-			bitgrid_t next(2, dimension(n_out.size(), 1), 0, 0);
-			bool valid = ca.next_state(sim_grid, p, next);
+			uint64_t key, next;
+			bool valid = next_state_memo_at(p, key, next);
 			if(valid)
-			 new_changable += bpatch_t(p, pseudo_int{next.raw_value()}, recent_grid[p]);
+			 new_changable += bpatch_t(p, pseudo_int{next}, recent_grid[p]);
 #ifdef DEBUG_ERRORS
 			if(valid && !sim_grid.contains(p))
 			 throw "ERROR: cells next to the border got active...";
@@ -320,7 +398,8 @@ protected:
 		// only readers of recently active points can be active now
 		// (TODO: and the nodes themselves...?)
 		// these are all possible active points
-		std::vector<point> new_vari = my_variable_points(readers_of(cur.variable));
+		new_vari = my_variable_points(readers_of(cur.variable));
+		} // timer scope
 		detail.filter(cur, new_vari, activated);
 
 #ifdef VERBOSE_OUTPUT
@@ -330,6 +409,8 @@ protected:
 		 * update dependency graph
 		 */
 
+		{
+		stats_t::phase_timer timer(stats, phase_t::dep_graph);
 		for(const point& p : new_changable.area())
 		for(const point& changed : activated) // TODO: zip
 		if(readers_of.is_neighbour_of(p, changed))
@@ -353,12 +434,17 @@ protected:
 			// this fails in rare cases (root node)
 			if(itr1 != bug_patch.area().end() && itr2 != new_changable.area().end())
 			{
-				sim_grid[changed] = bug_patch.old_conf()[ch_pos];
-				bitgrid_t other_next(2, dimension(n_out.size(), 1), 0, 0);
-				ca.next_state(sim_grid, p, other_next);
-				sim_grid[changed] = bug_patch.conf()[ch_pos];
-
-				if(other_next.raw_value() != (uint64_t)new_changable.conf()[ch_pos])
+				// next state of p if changed had its old state:
+				// the memo holds p's current key, so only changed's
+				// bits need to be replaced
+				const int n_idx = ca.n_in().index_of(changed - p);
+				assert(n_idx >= 0);
+				const uint64_t other_key = ca.replace_in_key(
+					next_state_memo[sim_grid.index_h(p)].key,
+					n_idx, bug_patch.old_conf()[ch_pos]);
+				const uint64_t other_next = ca.next_state_of_key(other_key);
+
+				if(other_next != (uint64_t)new_changable.conf()[nc_pos])
 				{
 					const m_dep_graph_t::edge_t e_new =
 						dep_graph.try_add_edge(changed, p).first;
@@ -371,6 +457,7 @@ protected:
 				}
 			}
 		}
+		} // timer scope
 
 		new_changable.apply_bwd(recent_grid);
 
@@ -379,8 +466,18 @@ protected:
 		 */
 
 		{
-			patch_t new_patch = (cur.patch + bug_patch);
-			const auto dict_itr = dict.left.find(new_patch);
+			patch_t new_patch;
+			{
+				stats_t::phase_timer timer(stats, phase_t::patch_arith);
+				new_patch = cur.patch + bug_patch;
+			}
+			int tar_id;
+			{
+				stats_t::phase_timer timer(stats, phase_t::dict_lookup);
+				tar_id = dict.find(new_patch);
+				if(!tar_id)
+				 dict.insert(new_patch, stack_data::next_id());
+			}
 
 			const auto emplace_to_stack = [&]() {
 				std::vector<point> activated_v;
@@ -392,19 +489,18 @@ protected:
 					cur.id, new_changable, v_n);
 			};
 
-			if(dict_itr == dict.left.end())
+			if(!tar_id)
 			{
-				dict.insert( dict_t::value_type(new_patch, stack_data::next_id()) );
 				emplace_to_stack(); // see a few lines above...
 			}
 			else // node is known
 			{
-				const int tar_id = dict_itr->second;
 #ifdef VERBOSE_OUTPUT
 				std::cerr << mk_print(activated) << std::endl;
 #endif
 				if(tar_id == cur.id)
 				 throw "error: self-cycle";
+				stats_t::phase_timer timer(stats, phase_t::scc);
 				if((cur.id > tar_id) && scc_algo.check_for_back_edge(cur.id, tar_id) )
 				{
 #ifdef VERBOSE_OUTPUT
@@ -493,15 +589,17 @@ protected:
 				++scc_size;
 
 				// take scc with least difference to start
-				auto dict_itr = dict.right.find(v_scc);
-				if(dict_itr->second.size() < best_patch.size())
-				 best_patch = std::move(dict_itr->second);
+				if(dict.patch_size(v_scc) < best_patch.size())
+				 best_patch = dict.at(v_scc);
 #ifdef DELETE_UNUSED_VERTS
-				dict.right.erase(dict_itr);
+				dict.erase(v_scc);
 #endif
 			};
 
-			scc_algo.on_finish_dfs_node(cur.id, cb);
+			{
+				stats_t::phase_timer timer(stats, phase_t::scc);
+				scc_algo.on_finish_dfs_node(cur.id, cb);
+			}
 
 			if((scc_size > 1) // make sccs...
 				&& !cur.result // ... if we did not m_gather_result...
@@ -526,6 +624,7 @@ protected:
 
 			if(cur.src_id)
 			{
+				stats_t::phase_timer timer(stats, phase_t::scc);
 				scc_algo.on_finish_new_edge(cur.src_id, cur.id);
 			}
 
@@ -585,8 +684,12 @@ protected:
 			else
 			{
 
-				auto dict_itr = dict.left.find(cur.patch);
-				if(dict_itr == dict.left.end())
+				bool known;
+				{
+					stats_t::phase_timer timer(stats, phase_t::dict_lookup);
+					known = dict.find(cur.patch);
+				}
+				if(!known)
 				{
 					throw "dict did not contain current patch, this can not happen";
 				}
@@ -620,6 +723,8 @@ protected:
 					}
 					else
 					{
+						stats.inform_sizes(stack.size(), stack.swapped(),
+							dict.size(), dict.swapped());
 						stats.inform_new_vertex(cur.patch.area());
 						static int cntr = 0;
 						if(!(++cntr % 1000))
@@ -646,7 +751,10 @@ protected:
 
 						// compute scc vector and first scc/bitmask
 						{
-							cur.sccs = detail.make_sccs(cur, cur.variable); // greedy: O(1)
+							{
+								stats_t::phase_timer timer(stats, phase_t::scc);
+								cur.sccs = detail.make_sccs(cur, cur.variable); // greedy: O(1)
+							}
 							std::size_t cur_children = 0;
 							for(const auto& scc : cur.sccs)
 							 cur_children += (1 << scc.size());
@@ -806,6 +914,8 @@ protected:
 			prev_grid = recent_grid;
 
 			zero_grid = grid_t(sim_grid.human_dim(), sim_grid.border_width(), 0, 0);
+			next_state_memo.assign(sim_grid.internal_dim().area(),
+				next_state_memo_t { no_key(), 0 });
 			zero_grid_2 = zero_grid;
 
 			scc_finder.init(sim_grid.human_dim());
@@ -860,10 +970,9 @@ protected:
 
 			if(!dict.empty())
 			{
-				for(const auto& pr : dict)
-				{
-					std::cerr << "dict: " << mk_print(pr.left) << " <-> " << mk_print(pr.right) << std::endl;
-				}
+				dict.for_each([&](const patch_t& p, int id) {
+					std::cerr << "dict: " << mk_print(p) << " <-> " << mk_print(id) << std::endl;
+				});
 				throw "dict should be empty";
 			}
 			dict.clear();
@@ -887,6 +996,19 @@ public:
 	//! ctor taking an istream to a ca table file
 	brute_forcer(std::istream& is, cell_t border, bool dump_on_exit);
 
+	//! limits the memory used for the search stack and the dictionary,
+	//! swapping the rest to files in @a swap_dir (nullptr for $TMPDIR)
+	//! @param budget_bytes 0 for no limit (default)
+	void set_memory_budget(std::size_t budget_bytes, const char* swap_dir)
+	{
+		// the dict is accessed randomly, so it gets the larger part
+		stack.set_budget(budget_bytes >> 2, swap_dir);
+		dict.set_budget(budget_bytes - (budget_bytes >> 2), swap_dir);
+	}
+
+	//! writes periodic statistics as json lines to @a filename
+	void set_stats_log(const char* filename) { stats.set_json_log(filename); }
+
 	virtual ~brute_forcer() noexcept {}
 };
 
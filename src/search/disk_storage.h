@@ -0,0 +1,395 @@
+/*************************************************************************/
+/* sca toolsuite - a toolsuite to simulate cellular automata.            */
+/* Copyright (C) 2011-2019                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/sca-toolsuite                       */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+//! @file disk_storage.h containers which spill to disk if they exceed
+//!   a memory budget, used by the brute force search
+
+#ifndef DISK_STORAGE_H
+#define DISK_STORAGE_H
+
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+
+#include "io/serial.h"
+#include "types.h"
+
+namespace brute
+{
+
+//! unnamed temporary file for swapping
+//! the file is unlinked after opening, so it vanishes even on crashes
+class swap_file_t
+{
+	std::fstream _stream;
+public:
+	std::fstream& stream() { return _stream; }
+
+	//! @param dir directory for the file, or nullptr for $TMPDIR
+	swap_file_t(const char* dir)
+	{
+		if(!dir)
+		 dir = std::getenv("TMPDIR");
+		std::string name = std::string(dir ? dir : "/tmp")
+			+ "/sca_search_XXXXXX";
+		const int fd = mkstemp(&name[0]);
+		if(fd < 0)
+		 throw "Could not create swap file";
+		_stream.open(name, std::ios::in | std::ios::out
+			| std::ios::binary | std::ios::trunc);
+		close(fd);
+		unlink(name.c_str());
+		if(!_stream.good())
+		 throw "Could not open swap file";
+	}
+};
+
+/**
+ * @brief Stack which keeps only its top elements in memory.
+ *
+ * If the estimated size of the in-memory elements exceeds the budget,
+ * the lower half of them is written to a swap file as one chunk. Chunks
+ * are read back (LIFO) when the in-memory part runs empty.
+ *
+ * References to the top element stay valid on pushing, like for
+ * std::stack with std::deque.
+ *
+ * T needs a ctor from io::deserializer, a serializer operator
+ * and a member function approx_bytes().
+ */
+template<class T>
+class disk_stack_t
+{
+	struct chunk_t
+	{
+		std::streamoff offset;
+		std::size_t count;
+	};
+
+	std::deque<T> _mem;
+	std::size_t _mem_bytes = 0;
+	std::vector<chunk_t> _chunks;
+	std::size_t _budget;
+	const char* _swap_dir;
+	std::unique_ptr<swap_file_t> _file;
+	std::streamoff _file_end = 0;
+
+	void spill()
+	{
+		if(!_file)
+		 _file.reset(new swap_file_t(_swap_dir));
+		std::fstream& fs = _file->stream();
+		fs.seekp(_file_end);
+		io::serializer ser(fs);
+
+		const std::size_t count = _mem.size() >> 1;
+		_chunks.push_back(chunk_t { _file_end, count });
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			_mem_bytes -= _mem.front().approx_bytes();
+			ser << _mem.front();
+			_mem.pop_front();
+		}
+		fs.flush();
+		_file_end = fs.tellp();
+	}
+
+	void reload()
+	{
+		const chunk_t chunk = _chunks.back();
+		_chunks.pop_back();
+
+		std::fstream& fs = _file->stream();
+		fs.seekg(chunk.offset);
+		io::deserializer des(fs);
+		for(std::size_t i = 0; i < chunk.count; ++i)
+		{
+			_mem.emplace_back(des);
+			_mem_bytes += _mem.back().approx_bytes();
+		}
+		_file_end = chunk.offset; // the chunk's space can be reused
+	}
+
+public:
+	//! @param budget_bytes memory budget, 0 means unlimited
+	disk_stack_t(std::size_t budget_bytes = 0,
+		const char* swap_dir = nullptr) :
+		_budget(budget_bytes),
+		_swap_dir(swap_dir)
+	{}
+
+	void set_budget(std::size_t budget_bytes, const char* swap_dir) {
+		_budget = budget_bytes;
+		_swap_dir = swap_dir;
+	}
+
+	T& top() { return _mem.back(); }
+	const T& top() const { return _mem.back(); }
+
+	template<class ...Args>
+	void emplace(Args&&... args)
+	{
+		_mem.emplace_back(std::forward<Args>(args)...);
+		_mem_bytes += _mem.back().approx_bytes();
+		// keep the top elements, which might be referenced
+		if(_budget && _mem_bytes > _budget && _mem.size() > 4)
+		 spill();
+	}
+
+	void pop()
+	{
+		_mem_bytes -= _mem.back().approx_bytes();
+		_mem.pop_back();
+		if(_mem.empty() && !_chunks.empty())
+		 reload();
+	}
+
+	std::size_t size() const {
+		std::size_t res = _mem.size();
+		for(const chunk_t& c : _chunks)
+		 res += c.count;
+		return res;
+	}
+	bool empty() const { return _mem.empty(); }
+
+	//! number of elements currently written to disk
+	std::size_t swapped() const { return size() - _mem.size(); }
+};
+
+/**
+ * @brief Bidirectional map patch <-> id, similar to a boost::bimap,
+ *   which can swap the patches out to disk.
+ *
+ * Only a small index entry (hash, size, file offset) stays in memory for
+ * each patch. Lookups by patch compare the full patch only on hash hits,
+ * so unknown patches never cause disk reads.
+ *
+ * The swap file is append-only; its space is reclaimed on clear().
+ */
+template<class Patch>
+class patch_dict_t
+{
+	struct entry_t
+	{
+		std::size_t hash;
+		std::size_t size;
+		std::streamoff offset; //!< -1 if the patch is in memory
+	};
+
+	std::unordered_map<int, entry_t> _by_id;
+	std::unordered_multimap<std::size_t, int> _by_hash;
+	std::unordered_map<int, Patch> _resident;
+	//! oldest first, may contain erased ids, only kept if there is a budget
+	std::deque<int> _resident_order;
+	std::size_t _resident_bytes = 0;
+
+	std::size_t _budget;
+	const char* _swap_dir;
+	std::unique_ptr<swap_file_t> _file;
+	std::streamoff _file_end = 0;
+
+	static std::size_t hash_of(const Patch& p)
+	{
+		std::size_t h = p.size();
+		const auto mix = [&](std::size_t v) {
+			h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2); };
+		for(const auto& pt : p.area())
+		{
+			mix((std::size_t)pt.x);
+			mix((std::size_t)pt.y);
+		}
+		for(const auto& c : p.conf())
+		 mix((std::size_t)c);
+		for(const auto& c : p.old_conf())
+		 mix((std::size_t)c);
+		return h;
+	}
+
+	static std::size_t approx_bytes(const Patch& p)
+	{
+		// set nodes plus two confs
+		return sizeof(Patch) + p.size() * (48 + 2);
+	}
+
+	Patch load(std::streamoff offset) const
+	{
+		std::fstream& fs = _file->stream();
+		fs.seekg(offset);
+		io::deserializer des(fs);
+		Patch res;
+		des >> res;
+		return res;
+	}
+
+	void spill()
+	{
+		if(!_file)
+		 _file.reset(new swap_file_t(_swap_dir));
+		std::fstream& fs = _file->stream();
+		fs.seekp(_file_end);
+		io::serializer ser(fs);
+
+		while(_resident_bytes > (_budget >> 1) && !_resident_order.empty())
+		{
+			const int id = _resident_order.front();
+			_resident_order.pop_front();
+			auto itr = _resident.find(id);
+			if(itr != _resident.end()) // otherwise, it has been erased
+			{
+				_by_id.at(id).offset = fs.tellp();
+				ser << itr->second;
+				_resident_bytes -= approx_bytes(itr->second);
+				_resident.erase(itr);
+			}
+		}
+		fs.flush();
+		_file_end = fs.tellp();
+	}
+
+	//! removes the erased ids from _resident_order once they dominate it
+	void compact_order()
+	{
+		if(_resident_order.size() <= (_resident.size() << 1) + 64)
+		 return;
+		std::deque<int> order;
+		for(const int id : _resident_order)
+		if(_resident.count(id))
+		 order.push_back(id);
+		_resident_order.swap(order);
+	}
+
+public:
+	//! @param budget_bytes memory budget for patches, 0 means unlimited
+	patch_dict_t(std::size_t budget_bytes = 0,
+		const char* swap_dir = nullptr) :
+		_budget(budget_bytes),
+		_swap_dir(swap_dir)
+	{}
+
+	void set_budget(std::size_t budget_bytes, const char* swap_dir)
+	{
+		// the order is only tracked with a budget
+		if(!budget_bytes)
+		 _resident_order.clear();
+		else if(!_budget)
+		for(const auto& pr : _resident)
+		 _resident_order.push_back(pr.first);
+		_budget = budget_bytes;
+		_swap_dir = swap_dir;
+	}
+
+	//! returns the id of @a p, or 0 if @a p is unknown
+	int find(const Patch& p) const
+	{
+		const std::size_t h = hash_of(p);
+		const auto range = _by_hash.equal_range(h);
+		for(auto itr = range.first; itr != range.second; ++itr)
+		{
+			const entry_t& e = _by_id.at(itr->second);
+			if(e.size != p.size())
+			 continue;
+			const bool equal = (e.offset < 0)
+				? (_resident.at(itr->second) == p)
+				: (load(e.offset) == p);
+			if(equal)
+			 return itr->second;
+		}
+		return 0;
+	}
+
+	//! @param id must be > 0
+	void insert(const Patch& p, int id)
+	{
+		const std::size_t h = hash_of(p);
+		_by_id.emplace(id, entry_t { h, p.size(), -1 });
+		_by_hash.emplace(h, id);
+		_resident.emplace(id, p);
+		_resident_bytes += approx_bytes(p);
+		if(_budget)
+		{
+			_resident_order.push_back(id);
+			if(_resident_bytes > _budget)
+			 spill();
+		}
+	}
+
+	//! size of the patch with id @a id, O(1)
+	std::size_t patch_size(int id) const { return _by_id.at(id).size; }
+
+	//! returns a copy of the patch with id @a id
+	Patch at(int id) const
+	{
+		const entry_t& e = _by_id.at(id);
+		return (e.offset < 0) ? _resident.at(id) : load(e.offset);
+	}
+
+	void erase(int id)
+	{
+		auto itr = _by_id.find(id);
+		const auto range = _by_hash.equal_range(itr->second.hash);
+		for(auto hitr = range.first; hitr != range.second; ++hitr)
+		if(hitr->second == id)
+		{
+			_by_hash.erase(hitr);
+			break;
+		}
+		if(itr->second.offset < 0)
+		{
+			auto ritr = _resident.find(id);
+			_resident_bytes -= approx_bytes(ritr->second);
+			_resident.erase(ritr);
+			if(_budget)
+			 compact_order();
+		}
+		_by_id.erase(itr);
+	}
+
+	bool empty() const { return _by_id.empty(); }
+	std::size_t size() const { return _by_id.size(); }
+	//! number of patches currently written to disk
+	std::size_t swapped() const { return _by_id.size() - _resident.size(); }
+
+	void clear()
+	{
+		_by_id.clear();
+		_by_hash.clear();
+		_resident.clear();
+		_resident_order.clear();
+		_resident_bytes = 0;
+		_file_end = 0;
+	}
+
+	//! calls @a ftor(patch, id) for all entries
+	template<class Functor>
+	void for_each(const Functor& ftor) const
+	{
+		for(const auto& pr : _by_id)
+		 ftor(at(pr.first), pr.first);
+	}
+};
+
+}
+
+#endif // DISK_STORAGE_H
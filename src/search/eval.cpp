@@ -252,7 +252,7 @@ struct data : public types
 			std::size_t i = (std::size_t)idx;
 			for(std::size_t j = 0; j < io_grids[i].size(); ++j)
 			{
-				cell_t area_id = scc_finder.visited_grid()[areas[i][j].front()];
+				cell_t area_id = scc_finder.component_id(areas[i][j].front());
 				for(cell_t& c : io_grids[i][j])
 				 c = -area_id;
 				o << grid_counter++ << "\n\n" << io_grids[i][j] << "\n";
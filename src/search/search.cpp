@@ -19,7 +19,6 @@
 /*************************************************************************/
 
 #include <memory>
-#include <sys/resource.h>
 #include <csignal>
 
 #include "general.h"
@@ -51,28 +50,6 @@ void catch_sigint()
 	sigaction(SIGINT, &handler, NULL);
 }
 
-// TODO: http://stackoverflow.com/questions/2275550/
-//	change-stack-size-for-a-c-application-
-//	in-linux-during-compilation-with-gnu-com
-void increase_stack_size(std::size_t megabyte)
-{
-	const rlim_t kStackSize = megabyte * 1024 * 1024;   // min stack size = 16 MB
-	struct rlimit rl;
-	int result;
-
-	result = getrlimit(RLIMIT_STACK, &rl);
-	if (result == 0)
-	if (rl.rlim_cur < kStackSize)
-	{
-		rl.rlim_cur = kStackSize;
-		result = setrlimit(RLIMIT_STACK, &rl);
-		if (result != 0)
-		{
-			fprintf(stderr, "setrlimit returned result = %d\n", result);
-		}
-	}
-}
-
 // TODO: StackOverflow
 std::string get_file_contents(const char *filename) // TODO: move?
 {
@@ -102,6 +79,9 @@ class MyProgram : public Program
 		bool dump_on_exit = true;
 		int dead_state = std::numeric_limits<int>::max();
 		bool pipe = false;
+		std::size_t ram_budget = 0;
+		const char* swap_dir = nullptr;
+		const char* stats_file = nullptr;
 
 		catch_sigint();
 
@@ -112,9 +92,23 @@ class MyProgram : public Program
 		assert_usage(argc >= 3);
 		switch(argc)
 		{
+			case 9:
+				stats_file = argv[8];
+			case 8:
+				if(strcmp(argv[7], "-"))
+				 swap_dir = argv[7];
+			case 7:
+			{
+				char* unit;
+				assert_usage(isdigit(argv[6][0]));
+				ram_budget = strtoul(argv[6], &unit, 10);
+				assert_usage(!*unit || (!strcmp(unit, "k")));
+				ram_budget <<= (*unit ? 10 : 20);
+			}
 			case 6:
-				assert_usage(!strcmp(argv[5], "pipe"));
-				pipe = true;
+				assert_usage(!strcmp(argv[5], "pipe")
+					|| !strcmp(argv[5], "nopipe"));
+				pipe = (!strcmp(argv[5], "pipe"));
 			case 5:
 				type = argv[4];
 			case 4:
@@ -149,7 +143,12 @@ class MyProgram : public Program
 		std::unique_ptr<base> algo = nullptr;
 		if(!strcmp(type, "greedy"))
 		{
-			algo.reset(new greedy::algo(in, dead_state, dump_on_exit));
+			greedy::algo* greedy_algo =
+				new greedy::algo(in, dead_state, dump_on_exit);
+			greedy_algo->set_memory_budget(ram_budget, swap_dir);
+			if(stats_file)
+			 greedy_algo->set_stats_log(stats_file);
+			algo.reset(greedy_algo);
 		}
 		else
 		 throw "Unknown algorithm type specified";
@@ -199,10 +198,9 @@ class MyProgram : public Program
 
 int main(int argc, char** argv)
 {
-	increase_stack_size(1000);
-
 	HelpStruct help;
-	help.syntax = "usr/search <ca-table-file> <border> [dump|nodump [split|left|dumb]]"
+	help.syntax = "usr/search <ca-table-file> <border> [dump|nodump [split|left|dumb "
+		"[pipe|nopipe [<ram-budget> [<swap-dir> [<stats-file>]]]]]]"
 		"";
 	help.description = "Computes all end configurations "
 		"using split algorithm.";
@@ -213,6 +211,15 @@ int main(int argc, char** argv)
 	help.add_param("dump|nodump", "whether to dump graph on exit/abort");
 	help.add_param("split|left|dumb",
 		"algorithm to use, default is split");
+	help.add_param("pipe|nopipe",
+		"whether to write results to stdout instead of results.dat");
+	help.add_param("ram-budget", "memory for search stack and dictionary "
+		"in MB, or in kB with suffix k, the rest is swapped to disk. "
+		"0 (default) means no limit");
+	help.add_param("swap-dir", "directory for swap files, "
+		"- (default) means $TMPDIR or /tmp");
+	help.add_param("stats-file", "file to write search statistics to, "
+		"as one json object per line");
 
 	MyProgram p;
 	return p.run(argc, argv, &help);
@@ -18,6 +18,8 @@
 /* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
 /*************************************************************************/
 
+#include <sys/resource.h>
+
 #include "stats.h"
 
 #define DUMP_STATS
@@ -32,6 +34,8 @@ void stats_t::dump() const
 	std::cerr << "movable nodes (=cuts): " << movable_nodes << std::endl;
 	std::cerr << "isolated points (=cuts): " << isolated << std::endl;
 	std::cerr << "extra nodes from stack (=cuts): " << extra_stack << std::endl;
+	std::cerr << "next state memo hits: " << memo_hits << " / "
+		<< (memo_hits + memo_misses) << std::endl;
 	std::cerr << "extra nodes global: ";
 	if(has_extra_nodes)
 		std::cerr <<  extra_nodes << std::endl;
@@ -62,3 +66,54 @@ void stats_t::dump() const
 	//std::cerr << "progress: ";
 #endif // DUMP_STATS
 }
+
+void stats_t::set_json_log(const char* filename)
+{
+	json_log.open(filename);
+	if(!json_log.good())
+	 throw "Could not open stats file";
+}
+
+void stats_t::write_json()
+{
+	if(!json_log.is_open())
+	 return;
+
+	using secs = std::chrono::duration<double>;
+	const clock_type::time_point now = clock_type::now();
+	const double interval = secs(now - last_dump_time).count();
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	static const char* const phase_names[] = { "next_state",
+		"patch_arith", "dict_lookup", "scc", "dep_graph" };
+	static_assert(sizeof(phase_names)/sizeof(phase_names[0])
+		== (std::size_t)phase_t::size, "phase names missing");
+
+	json_log << "{\"time_s\": " << secs(now - wall_start).count()
+		<< ", \"vertices\": " << n_verts
+		<< ", \"nodes_per_sec\": " << (interval > 0.0
+			? (n_verts - last_dump_verts) / interval : 0.0)
+		<< ", \"depth\": " << tree_depth
+		<< ", \"frontier\": " << frontier
+		<< ", \"frontier_swapped\": " << frontier_swapped
+		<< ", \"max_frontier\": " << max_frontier
+		<< ", \"dict\": " << dict_size
+		<< ", \"dict_swapped\": " << dict_swapped
+		<< ", \"max_dict\": " << max_dict_size
+		<< ", \"peak_rss_kb\": " << usage.ru_maxrss
+		<< ", \"cuts\": {\"movable\": " << movable_nodes
+		<< ", \"isolated\": " << isolated
+		<< ", \"extra_stack\": " << extra_stack << "}"
+		<< ", \"next_state_memo\": {\"hits\": " << memo_hits
+		<< ", \"misses\": " << memo_misses << "}"
+		<< ", \"phases_s\": {";
+	for(std::size_t i = 0; i < (std::size_t)phase_t::size; ++i)
+	 json_log << (i ? ", " : "") << "\"" << phase_names[i] << "\": "
+		<< secs(phase_time[i]).count();
+	json_log << "}}" << std::endl;
+
+	last_dump_time = now;
+	last_dump_verts = n_verts;
+}
@@ -21,7 +21,10 @@
 #ifndef STATS_H
 #define STATS_H
 
+#include <array>
+#include <chrono>
 #include <ctime>
+#include <fstream>
 #include "types.h"
 
 struct stat_results_t
@@ -39,12 +42,26 @@ struct stat_results_t
 	}
 };
 
+//! phases of the search which are timed separately
+enum class phase_t
+{
+	next_state, //!< evaluating the ca on cells
+	patch_arith, //!< adding and applying patches
+	dict_lookup, //!< finding and inserting patches in the dictionary
+	scc, //!< tarjan and splitting cells into sccs
+	dep_graph, //!< updating the dependency graph
+	size
+};
+
 class stats_t : public types
 {
+	using clock_type = std::chrono::steady_clock;
+
 	std::size_t n_verts = 0;
 	std::set<point> super_area; //!< records the maximum of all ever activated cells
 	std::size_t extra_nodes = 0, extra_stack = 0,
 		 movable_nodes = 0, isolated = 0;
+	std::size_t memo_hits = 0, memo_misses = 0; //!< next state memo
 	bool has_extra_nodes;
 	static constexpr std::size_t dump_interval() { return 1000; }
 	int cur_vertex;
@@ -54,6 +71,18 @@ class stats_t : public types
 #endif
 	clock_t start_time;
 
+	/*
+	 * instrumentation, written as json lines to json_log
+	 */
+	std::array<clock_type::duration, (std::size_t)phase_t::size> phase_time;
+	std::size_t frontier = 0, frontier_swapped = 0, max_frontier = 0;
+	std::size_t dict_size = 0, dict_swapped = 0, max_dict_size = 0;
+	clock_type::time_point wall_start, last_dump_time;
+	std::size_t last_dump_verts = 0;
+	std::ofstream json_log;
+
+	void write_json();
+
 	struct depth_wise_t
 	{
 		std::size_t nodes_started = 0,
@@ -75,29 +104,67 @@ public:
 			get_runtime() };
 	}
 
+	//! measures the time of a phase as long as it is in scope
+	class phase_timer
+	{
+		stats_t& stats;
+		const phase_t phase;
+		const clock_type::time_point start;
+	public:
+		phase_timer(stats_t& stats, phase_t phase) :
+			stats(stats), phase(phase), start(clock_type::now()) {}
+		phase_timer(const phase_timer&) = delete;
+		~phase_timer() {
+			stats.phase_time[(std::size_t)phase] += clock_type::now() - start;
+		}
+	};
+
+	//! opens @a filename to write one json line on each dump
+	void set_json_log(const char* filename);
+
 	void set_cur_vertex(const int& _cur_vertex) { cur_vertex = _cur_vertex; }
+	void inform_sizes(std::size_t _frontier, std::size_t _frontier_swapped,
+		std::size_t _dict_size, std::size_t _dict_swapped)
+	{
+		frontier = _frontier;
+		frontier_swapped = _frontier_swapped;
+		dict_size = _dict_size;
+		dict_swapped = _dict_swapped;
+		max_frontier = std::max(max_frontier, frontier);
+		max_dict_size = std::max(max_dict_size, dict_size);
+	}
 	void inform_new_vertex(const std::set<point>& area)
 	{
 		for(const point& p : area)
 		 super_area.insert(p);
-		if(!(++n_verts % dump_interval())) dump();
+		if(!(++n_verts % dump_interval())) {
+			dump();
+			write_json();
+		}
 	}
 	void inform_extra_node() { ++extra_nodes; }
 	void inform_extra_node_stack() { ++extra_stack; }
 	void inform_movable_node() { ++movable_nodes; }
 	void inform_isolated_point() { ++isolated; }
+	void inform_memo_hit() { ++memo_hits; }
+	void inform_memo_miss() { ++memo_misses; }
 	void dump() const;
 	stats_t(bool has_extra_nodes)
 		: has_extra_nodes(has_extra_nodes),
 		start_time(clock()),
+		wall_start(clock_type::now()),
+		last_dump_time(wall_start),
 		at_depth {1} // one root node (TODO)
-		 {}
+	{
+		phase_time.fill(clock_type::duration::zero());
+	}
 	// dtors are noexcept(true) by default...
 	// hopefully this never happens...
 	~stats_t() noexcept(false) {
 		if(tree_depth != 0)
 		 throw "Error: Tree depth not 0 on exiting.";
 		dump();
+		write_json();
 	}
 
 	void est_cur_children(std::size_t estimation)
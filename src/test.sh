@@ -42,6 +42,7 @@ call_test ()
 call_test "Testing core/create (1), core/all_equals" 1 "core/create 8 8 1 | core/all_equals 1"
 call_test "Testing core/create (2)" 1 "core/create 8 8 | core/all_equals 0"
 call_test "Testing math/add" 1 "core/create 2 2 0 | math/add 0 1 2 3 | core/all_equals 1"
+call_test "Testing math/comb" 1 "core/create 4 4 1 | math/comb max 'core/create 4 4 3' | math/comb sub 2 | core/all_equals 1"
 
 call_test "Testing the math/coords script" 1 "core/create 2 2 0 | math/add `./math/coords 2 0 0` `./math/coords 2 0 1` `./math/coords 2 1 0` `./math/coords 2 1 1` | core/all_equals 1"
 
@@ -72,6 +73,7 @@ EQ_3_P_1='((x==y||x==8-y)&&v==1)||(x==4&&y==4&&v==0)||(x!=y&&x!=8-y&&v==3)'
 call_test "Testing algo/fix s (2)" 1 "core/create 9 9 3 | math/add `./math/coords 9 4 4` | algo/fix s | math/equation \$EQ_3_P_1 | core/all_equals 1"
 call_test "Testing algo/fix l (2)" 1 "core/create 9 9 3 | math/add `./math/coords 9 4 4` | algo/fix l `./math/coords 9 4 4` | io/avalanches_bin2human 9 | io/seq_to_field 9 9  | math/equation 'v-min(min(x+1,9-x),min(y+1,9-y))' | core/all_equals 0"
 call_test "Testing algo/fix (special)" 1 "core/create 3 3 4 | algo/relax s `./math/coords 3 1 1` 0 | core/all_equals 4"
+call_test "Testing core/pipeline" 1 "core/pipeline 'create 4 4 8' fix | core/all_equals 2"
 
 call_test "Testing algo/relax s" 1 "core/create 9 9 3 | math/add `./math/coords 9 4 4` | algo/relax s | math/equation \$EQ_3_P_1 | core/all_equals 1"
 call_test "Testing algo/relax l" 1 "core/create 9 9 3 | math/add `./math/coords 9 4 4` | algo/relax l `./math/coords 9 4 4` | io/avalanches_bin2human 9 | io/seq_to_field 9 9  | math/equation 'v-min(min(x+1,9-x),min(y+1,9-y))' | core/all_equals 0"
@@ -103,14 +105,83 @@ call_test "Testing algo/random_throw (input)" 1 "core/create 9 9 3 | math/add `.
 call_test "Testing algo/random_throw (random)" 1 "core/create 9 9 0 | algo/random_throw random 1 42 | math/equation 'v<=1' | core/all_equals 1"
 
 call_test "Testing io/to_tga (0=green, 3=red)" 1 "algo/id 50 50 | io/to_tga 00ff00 ff0000 > /dev/null"
+call_test "Testing io/export" 1 "[ `printf '0 3\\n\\n3 0\\n' | io/export ppm text 00ff00 ff0000 | wc -c` == 34 ]"
+
+# prints the color map indices of a RLE TGA, row by row
+tga_indices()
+{
+	od -An -tu1 -v | awk '{ for(i = 1; i <= NF; ++i) b[n++] = $i }
+	END {
+		w = b[12] + 256 * b[13]
+		i = 18 + b[0] + (b[5] + 256 * b[6]) * b[7] / 8
+		while(i < n - 26) {
+			h = b[i++]; c = h % 128 + 1
+			for(k = 0; k < c; ++k)
+			 printf "%d%s", (h >= 128) ? b[i] : b[i + k], (++x % w) ? " " : "\n"
+			i += (h >= 128) ? 1 : c
+		}
+	}'
+}
+# runs longer than 128, raw packets longer than 128, and both mixed
+RLE_GRID="`printf '3 %.0s' $(seq 130)`0 1 0
+`printf '0 1 %.0s' $(seq 65)`2 2 2"
+call_test "Testing io/export (RLE TGA)" 1 "echo \"\$RLE_GRID\" | io/export tga text | tga_indices | cmp - <(echo \"\$RLE_GRID\")"
+
+# writes 32 bit ints
+bin_ints()
+{
+	for v in "$@"; do printf "\\x$(printf %02x $v)\\0\\0\\0"; done
+}
+# the grid 1 2 3 / 3 0 1 with a border of 1, as written by the serializer
+bin_grid()
+{
+	bin_ints 5 4 1 20 0
+	bin_ints 0 0 0 0 0 0 1 2 3 0 0 3 0 1 0 0 0 0 0 0
+}
+call_test "Testing io/export (binary input)" 1 "cmp <(bin_grid | io/export tga bin) <(printf '1 2 3\\n3 0 1\\n' | io/export tga text)"
+EXPORT_DIR=`mktemp -d`
+call_test "Testing io/export (outfile pattern)" 1 "printf '0 3\\n\\n3 0\\n' | io/export ppm text 000000 ffffff 0 3 \$EXPORT_DIR/f%02d.ppm && [ -s \$EXPORT_DIR/f00.ppm ] && [ -s \$EXPORT_DIR/f01.ppm ] && ! (echo 0 | io/export ppm text 000000 ffffff 0 3 \$EXPORT_DIR/%d%s 2>/dev/null) && ! (echo 0 | io/export ppm text 000000 ffffff 0 3 \$EXPORT_DIR/%%.ppm 2>/dev/null)"
+rm -r "$EXPORT_DIR"
 
 call_test "Testing algo/super (1)" 1 "core/create 2 2 2 | algo/super | core/all_equals 0"
 call_test "Testing algo/super (2)" 1 "core/create 2 2 3 | algo/super | core/all_equals 1"
 
 # ca
+CIRCUIT_TBL=`mktemp`
+ca/dump < ../../data/ca/circuit.txt > "$CIRCUIT_TBL" 2>/dev/null
+# prints the grid section of a search input file
+search_grid()
+{
+	sed -n '/^grid$/,/^unite$/{/^[-0-9]/p}' "$1"
+}
+CROSSING_SMALL=../../data/search/crossing_small.txt
 call_test "Testing ca/ca (1)" 1 "core/create 20 20 0 | ca/ca 'v:=v+2' end 4 | core/all_equals 8"
 call_test "Testing ca/ca (2)" 1 "echo '0 1 0 0 1 0 1 0 0 0 1 1 0 0' | ca/ca 'v:=(a[1,0]>=0)?(a[1,0]):0' end 1 | core/diff2 'echo 1 0 0 1 0 1 0 0 0 1 1 0 0 0'"
 call_test "Testing ca/ca (3)" 1 "core/create 20 20 4 | ca/ca 'v:=v+(-4*(v>=4))+(a[-1,0]>=4)+(a[0,-1]>=4)+(a[1,0]>=4)+(a[0,1]>=4)' | core/diff2 'core/create 20 20 4 | algo/S'"
+call_test "Testing ca/ca (cycles)" 1 "core/create 5 5 0 | ca/ca 'v:=1-v' end 1000001 | core/all_equals 1"
+LIFE='h[0]:=(a[-1,-1]>0)+(a[0,-1]>0)+(a[1,-1]>0)+(a[-1,0]>0)+(a[1,0]>0)+(a[-1,1]>0)+(a[0,1]>0)+(a[1,1]>0),v:=(v==0&&h[0]==3||v==1&&h[0]>=2&&h[0]<=3)'
+call_test "Testing ca/ca (bit-sliced)" 1 "core/create 5 5 0 | math/add 11 12 13 | ca/ca \"\$LIFE\" end 1001 | core/diff2 'core/create 5 5 0 | math/add 7 12 17'"
+call_test "Testing ca/ca (position dependent, not bit-sliced)" 1 "core/create 20 3 0 | ca/ca 'v:=(x>=10)' end 1 | core/diff2 \"core/create 20 3 0 | math/equation 'x>=10'\""
+call_test "Testing ca/ca (parallel async)" 1 "[ `core/create 8 8 0 | math/add 27 | ca/ca 'a[1,0]:=v,v:=a[1,0]' end 20 async 1 2 | tr ' ' '\\n' | grep -c '^1$'` == 1 ]"
+call_test "Testing ca/ca (multi-output, negative offset)" 1 "printf '0 0 0 0 0 0\\n0 0 0 5 0 0\\n0 0 0 0 0 0\\n' | ca/ca 'a[-1,0]:=a[-1,0]+(v>=2),v:=v-(v>=2)' end 10 sync > chips.tmp && [ \`tr ' ' '\\n' < chips.tmp | awk '{ s += \$1 } END { print s }'\` == 5 ] && printf '0 0 0 0 0 0\\n2 1 1 1 0 0\\n0 0 0 0 0 0\\n' | cmp - chips.tmp && rm chips.tmp"
+call_test "Testing ca/ca hashlife" 1 "echo 'v:=(v==0&&a[-1,0]+a[1,0]+a[0,-1]+a[0,1]==1)' | ca/dump > xor.tmp && core/create 9 9 0 | math/add 40 | ca/ca hashlife:xor.tmp end 3 | core/diff2 'core/create 9 9 0 | math/add 40 | ca/ca table:xor.tmp end 3' && rm xor.tmp"
+XOR_TBL=`mktemp`
+echo 'v:=(v+a[1,0])%2' | ca/dump > "$XOR_TBL" 2>/dev/null
+call_test "Testing ca/preimage" 1 "[ \`core/create 5 5 1 | ca/preimage \$XOR_TBL count 1\` == \`core/create 5 5 1 | ca/preimage \$XOR_TBL count 3\` ] && [ \`core/create 5 5 1 | ca/preimage \$XOR_TBL count 1\` == \$((\`core/create 5 5 1 | ca/preimage \$XOR_TBL dump | wc -l\` / 5)) ]"
+echo 'v:=a[-1,0]%2' | ca/dump > "$XOR_TBL" 2>/dev/null
+call_test "Testing ca/preimage (cells reading only the rim)" 1 "[ \`printf '0 0 0\\n0 1 0\\n0 0 0\\n' | ca/preimage \$XOR_TBL count 1\` == 0 ] && [ \`printf '0 0 0\\n0 0 0\\n0 0 0\\n' | ca/preimage \$XOR_TBL count 1\` == 3 ]"
+rm "$XOR_TBL"
+call_test "Testing ca/dead_cells" 1 "search_grid \$CROSSING_SMALL | ca/dead_cells \$CIRCUIT_TBL 1 > dead.tmp && search_grid \$CROSSING_SMALL | ca/dead_cells \$CIRCUIT_TBL 3 | cmp - dead.tmp && rm dead.tmp"
+call_test "Testing ca/active_cells" 1 "search_grid \$CROSSING_SMALL | ca/active_cells \$CIRCUIT_TBL 1 > active.tmp && search_grid \$CROSSING_SMALL | ca/active_cells \$CIRCUIT_TBL 3 | cmp - active.tmp && rm active.tmp"
+call_test "Testing ca/ensemble" 1 "[ `core/create 4 4 0 | ca/ensemble 'v:=v+2' 3 4 sync 1 2 | grep -c '^job'` == 3 ] && core/create 4 4 0 | ca/ensemble 'v:=v+2' 1 4 | tail -n +2 | core/all_equals 8"
+call_test "Testing ca/sparse" 1 "core/create 9 9 0 | math/add 40 | ca/sparse 'v:=(v==0&&a[-1,0]+a[1,0]+a[0,-1]+a[0,1]==1)' 3 1000000 1000000 | core/diff2 \"core/create 9 9 0 | math/add 40 | ca/ca 'v:=(v==0&&a[-1,0]+a[1,0]+a[0,-1]+a[0,1]==1)' end 3\""
+call_test "Testing ca/sparse (position dependent, unsupported)" 1 "! (core/create 3 3 0 | ca/sparse 'v:=(x>=10)' 1 0 0 20 1 2>/dev/null)"
+call_test "Testing ca/ca anim" 1 "core/create 20 20 0 | ca/ca 'v:=v+2' anim:1000 4 2>/dev/null | tail -n 2 | head -n 1 | core/all_equals 8"
+call_test "Testing ca/ca record, ca/replay" 1 "core/create 20 20 0 | ca/ca 'v:=v+2' record 4 > trajectory.tmp && ca/replay trajectory.tmp 2 | core/all_equals 4 && rm trajectory.tmp"
+call_test "Testing ca/ca record, ca/replay (multi-output)" 1 "printf '1 0 0 2 0 0\\n0 3 0 0 0 4\\n0 0 5 0 6 0\\n' > swap.tmp && ca/ca 'a[1,0]:=v,v:=a[1,0]' record 3 sync 7 < swap.tmp > trajectory.tmp && ca/replay trajectory.tmp 3 | core/diff2 \"ca/ca 'a[1,0]:=v,v:=a[1,0]' end 3 sync 7 < swap.tmp\" && rm swap.tmp trajectory.tmp"
+
+# img
+call_test "Testing img/transform (PAM)" 1 "[ `printf 'P7\\nWIDTH 2\\nHEIGHT 1\\nDEPTH 1\\nMAXVAL 255\\nTUPLTYPE GRAYSCALE\\nENDHDR\\n\\x05\\x07' | img/transform 'v:=max(v,a[1,0])' ARGB | tail -c 2 | od -An -tu1 | tr -d ' '` == '77' ]"
 
 # rotor stuff
 #call_test "Testing rotor/rotor s" 1 "core/create 10 10 0 | rotor/rotor s 'core/create 10 10 100' | core/diff2 \"core/create 10 10 0 | algo/S | rotor/rotor s 'core/create 10 10 100'\""
@@ -121,6 +192,12 @@ call_test "Testing ca/ca (3)" 1 "core/create 20 20 4 | ca/ca 'v:=v+(-4*(v>=4))+(
 # transition functions
 call_test "Testing ca/transf_by_grids " 1 "cat ../../data/ca_by_grid/circuit.txt  | ca/transf_by_grids | diff ../../data/ca/circuit.txt -"
 
+# search
+SWAP_DIR=`mktemp -d`
+call_test "Testing search (ram budget)" 1 "search/search \$CIRCUIT_TBL 3 nodump greedy pipe < ../../data/search/fork.txt > search.tmp 2>/dev/null && search/search \$CIRCUIT_TBL 3 nodump greedy pipe 2k \$SWAP_DIR < ../../data/search/fork.txt 2>/dev/null | cmp - search.tmp && rm search.tmp"
+rm -r "$SWAP_DIR"
+rm "$CIRCUIT_TBL"
+
 # scripts
 call_test "Testing math/add2" 1 "core/create 2 2 1 | math/add2 \"core/create 2 2 2\" | core/all_equals 3"
 call_test "Testing math/sub2" 1 "core/create 2 2 1 | math/sub2 \"core/create 2 2 2\" | core/all_equals -1"
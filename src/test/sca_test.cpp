@@ -20,7 +20,9 @@
 
 #include "general.h"
 #include "grid.h"
-//#include "ca.h"
+#include "ca.h"
+#include "ca_eqs.h"
+#include "pipeline.h"
 #include "io/serial.h"
 
 using sca::io::serializer;
@@ -109,6 +111,50 @@ class MyProgram : public Program
 		std::cerr << "int: " << i << std::endl;
 		}
 
+		{
+			// parallel async rounds must take the same cells as the
+			// serial reservation in the order of descending priorities
+			using sim_t = sca::ca::simulator_t<sca::ca::eqsolver_t,
+				def_coord_traits, def_cell_traits>;
+			const char* eq = "a[1,0]:=v,v:=a[1,0]";
+			sim_t par_sim(eq, true), ser_sim(eq, true);
+			grid_t start(dimension(32, 32), 1);
+			for(const point& p : start.points())
+			 start[p] = (p.x * 7 + p.y * 3) % 5;
+			par_sim.grid() = ser_sim.grid() = start;
+			par_sim.finalize(start.human_dim(), 42);
+			ser_sim.finalize(start.human_dim(), 42);
+			for(int round = 0; round < 20; ++round)
+			{
+				par_sim.run_once(sim_t::parallel_asynchronicity(4));
+				ser_sim.run_once(sim_t::parallel_asynchronicity(4, true));
+				assert_always(par_sim.grid() == ser_sim.grid(),
+					"parallel async differs from serial order");
+			}
+			assert_always(!(par_sim.grid() == start),
+				"parallel async did not change the grid");
+		}
+
+		{
+			// pipelines use the streams given to run(), not stdin/stdout
+			pipeline::pipeline_t pipe;
+			pipe.add("read");
+			pipe.add("comb add create 2 2 1");
+			pipe.add("write");
+			std::istringstream is("0 1\n2 0\n");
+			std::ostringstream os;
+			pipe.run(is, os);
+			assert_always(os.str() == "1 2\n3 1\n", "pipeline text io");
+
+			pipeline::pipeline_t tga_pipe;
+			tga_pipe.add("create 2 2");
+			tga_pipe.add("to_tga");
+			std::ostringstream tga_os;
+			tga_pipe.run(is, tga_os);
+			assert_always(tga_os.str().compare(0, 3, "\0\1\1", 3) == 0,
+				"pipeline tga output");
+		}
+
 		return exit_t::success;
 	}
 };